@@ -1,106 +1,838 @@
 
 #include "ContentDb.hpp"
 
+#include <set>
 #include <vector>
+#include <iterator>
+#include <sstream>
+#include <algorithm>
 #include <spdlog/spdlog.h>
+#include <osg/Timer>
 #include <osgDB/FileNameUtils>
 #include "IFileSys.hpp"
 
 namespace ehb
 {
-    void ContentDb::init(IFileSys& fileSys, const std::string& directory)
+    // rough estimate of the heap a string is holding onto outside of its small string buffer
+    static size_t stringFootprint(const std::string& value)
+    {
+        return value.capacity() >= sizeof(std::string) ? value.capacity() + 1 : 0;
+    }
+
+    // rough estimate of the memory held by a block and all of its children
+    static size_t blockFootprint(const FuelBlock* block)
+    {
+        size_t result = sizeof(FuelBlock) + stringFootprint(block->name()) + stringFootprint(block->type());
+
+        result += block->eachChild().capacity() * sizeof(FuelBlock*);
+        result += block->eachAttribute().capacity() * sizeof(Attribute);
+
+        for (const Attribute& attr : block->eachAttribute())
+        {
+            result += stringFootprint(attr.name) + stringFootprint(attr.type) + stringFootprint(attr.value);
+        }
+
+        for (const FuelBlock* child : block->eachChild())
+        {
+            result += blockFootprint(child);
+        }
+
+        return result;
+    }
+
+    /*
+     * walk the raw text of a gas file and report the header and byte range of every top level block without parsing it
+     * this only needs to understand enough of the format to not get confused by braces in comments, strings or [[ ]] expressions
+     */
+    template<typename Func>
+    static void eachTopLevelBlock(const std::string& data, Func func)
+    {
+        const size_t size = data.size();
+
+        size_t depth = 0, blockStart = 0;
+        std::string header;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            const char c = data[i];
+            const char next = i + 1 < size ? data[i + 1] : '\0';
+
+            if (c == '/' && next == '/')
+            {
+                i = std::min(data.find_first_of("\r\n", i), size);
+            }
+            else if (c == '/' && next == '*')
+            {
+                i = std::min(data.find("*/", i + 2), size - 1) + 1;
+            }
+            else if (c == '=')
+            {
+                // skip the entire value up to its terminating ';'
+                for (++i; i < size && data[i] != ';'; ++i)
+                {
+                    if (data[i] == '"')
+                    {
+                        for (++i; i < size && data[i] != '"'; ++i)
+                        {
+                            if (data[i] == '\\') ++i;
+                        }
+                    }
+                    else if (data[i] == '[' && i + 1 < size && data[i + 1] == '[')
+                    {
+                        i = std::min(data.find("]]", i + 2), size - 1) + 1;
+                    }
+                    else if (data[i] == '/' && i + 1 < size && data[i + 1] == '/')
+                    {
+                        i = std::min(data.find_first_of("\r\n", i), size);
+                    }
+                }
+            }
+            else if (c == '[' && depth == 0)
+            {
+                const size_t close = data.find(']', i);
+
+                if (close == std::string::npos) break;
+
+                header = data.substr(i + 1, close - i - 1);
+                blockStart = i;
+
+                i = close;
+            }
+            else if (c == '{')
+            {
+                depth++;
+            }
+            else if (c == '}' && depth > 0)
+            {
+                if (--depth == 0)
+                {
+                    func(header, blockStart, i + 1 - blockStart);
+                }
+            }
+        }
+    }
+
+    //! pull the block name out of headers like [t:template,n:farmgirl] or [farmgirl]
+    static std::string blockNameFromHeader(const std::string& header)
+    {
+        const auto index = header.rfind("n:");
+
+        std::string name = index != std::string::npos ? header.substr(index + 2) : header;
+
+        name.erase(0, name.find_first_not_of(" \t\r\n"));
+        name.erase(name.find_last_not_of(" \t\r\n") + 1);
+
+        return osgDB::convertToLowerCase(name);
+    }
+
+    const Attribute* GameObjectTmpl::attribute(const std::string& name) const
+    {
+        for (const GameObjectTmpl* tmpl = this; tmpl != nullptr; tmpl = tmpl->mSuper)
+        {
+            if (const Attribute* attr = tmpl->mBlock->attribute(name))
+            {
+                return attr;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::unique_ptr<Fuel> GameObjectTmpl::flatten() const
+    {
+        std::vector<const GameObjectTmpl*> chain;
+
+        for (const GameObjectTmpl* tmpl = this; tmpl != nullptr; tmpl = tmpl->mSuper)
+        {
+            chain.push_back(tmpl);
+        }
+
+        auto result = std::make_unique<Fuel>();
+
+        // start from the base template so every specialization overwrites what it inherits
+        for (auto itr = chain.rbegin(); itr != chain.rend(); ++itr)
+        {
+            (*itr)->mBlock->merge(result.get());
+        }
+
+        return result;
+    }
+
+    void ContentDb::init(IFileSys& fileSys, const std::string& directory, bool lazy)
     {
         auto log = spdlog::get("log");
         // log->set_level(spdlog::level::debug);
         log->debug("Starting init of ContentDb");
 
-        std::vector<std::unique_ptr<Fuel>> docs;
-        std::unordered_map<std::string, FuelBlock*> tmplMap;
+        std::lock_guard<std::mutex> lock(mutex);
 
-        fileSys.eachGasFile(directory, [&docs, &tmplMap](const std::string& filename, auto doc)
+        // any handle compiled before this point is pointing at templates that are about to go away
+        db.clear();
+        index.clear();
+        generation++;
+
+        this->fileSys = &fileSys;
+        this->directory = directory;
+        this->lazy = lazy;
+
+        osg::Timer initTimer;
+
+        if (lazy)
+        {
+            indexTemplates(directory);
+
+            log->info("ContentDb indexed {} templates in {:.3f}ms, templates will be resolved on first use", index.size(), initTimer.time_m());
+
+            return;
+        }
+
+        // flat view of the inheritance graph, parent and depth are indices into this vector
+        struct TmplNode
+        {
+            std::string name;
+            std::string filename;
+            const FuelBlock* block = nullptr;
+            std::shared_ptr<const Fuel> doc;
+
+            int32_t parent = -1;
+            int32_t depth = -1;
+        };
+
+        std::vector<TmplNode> nodes;
+        std::unordered_map<std::string, int32_t> nodeIndex;
+
+        fileSys.eachGasFile(directory, [this, &nodes, &nodeIndex](const std::string& filename, std::shared_ptr<const Fuel> doc)
             {
                 for (auto node : doc->eachChild())
                 {
-                    const auto result = tmplMap.emplace(osgDB::convertToLowerCase(node->name()), node);
+                    const std::string name = osgDB::convertToLowerCase(node->name());
+
+                    if (nodeIndex.emplace(name, static_cast<int32_t>(nodes.size())).second)
+                    {
+                        nodes.push_back({ name, filename, node, doc });
 
-                    if (result.second != true)
+                        // remember where each template came from so a reload of the file knows what it used to contain
+                        index.emplace(name, SourceLocation{ filename });
+                    }
+                    else
                     {
-                        spdlog::get("log")->warn("{}: duplicate entry {} found", filename, node->name());
+                        spdlog::get("log")->warn("{}: duplicate entry {} found, already defined in {}", filename, node->name(), nodes[nodeIndex[name]].filename);
                     }
                 }
-
-                docs.emplace_back(std::move(doc));
             });
 
-        log->debug("ContentDb is resolving {} templates", tmplMap.size());
+        log->debug("ContentDb is building the inheritance graph for {} templates", nodes.size());
 
-        std::function<void(const std::string&)> resolve;
+        // link every template to its parent so problems can be reported before anything gets resolved
+        for (auto& node : nodes)
+        {
+            if (const std::string specializes = osgDB::convertToLowerCase(node.block->valueOf("specializes")); !specializes.empty())
+            {
+                if (const auto itr = nodeIndex.find(specializes); itr != nodeIndex.end())
+                {
+                    node.parent = itr->second;
+                }
+                else
+                {
+                    // keep the template around as a base template so at least its own values are available
+                    log->error("{}: template {} specializes {} which could not be found", node.filename, node.name, specializes);
+                }
+            }
+        }
+
+        // depth of each template in the graph, walking each chain once and marking anything that loops back on itself
+        static constexpr int32_t visiting = -2, broken = -3;
+
+        size_t levelCount = 0;
 
-        resolve = [&resolve, &tmplMap, this](const std::string& name)
+        for (size_t i = 0; i < nodes.size(); ++i)
         {
-            auto log = spdlog::get("log");
+            std::vector<int32_t> chain;
 
-            if (db.count(name) == 0)
+            int32_t current = static_cast<int32_t>(i);
+
+            while (current != -1 && nodes[current].depth == -1)
             {
-                if (const auto itr = tmplMap.find(name); itr != tmplMap.end())
-                {
-                    FuelBlock* node = itr->second;
+                nodes[current].depth = visiting;
+                chain.push_back(current);
 
-                    const std::string specializes = osgDB::convertToLowerCase(node->valueOf("specializes"));
+                current = nodes[current].parent;
+            }
 
-                    FuelBlock* super = nullptr;
+            int32_t depth = current == -1 ? -1 : nodes[current].depth;
 
-                    if (!specializes.empty())
-                    {
-                        resolve(specializes);
+            // anything in the chain before this index only specializes into a cycle rather than being part of it
+            size_t loopStart = chain.size();
 
-                        if (const auto itr = db.find(specializes); itr != db.end())
-                        {
-                            super = itr->second.get();
-                        }
-                    }
+            if (depth == visiting)
+            {
+                // the chain walked back into itself, report the loop from the point it starts
+                loopStart = std::find(chain.begin(), chain.end(), current) - chain.begin();
 
-                    FuelBlock* newNode = super ? super->clone() : node->clone();
+                std::string cycle;
 
-                    if (super)
+                for (size_t j = loopStart; j < chain.size(); ++j)
+                {
+                    cycle += nodes[chain[j]].name + " -> ";
+                }
+
+                cycle += nodes[current].name;
+
+                log->error("{}: template {} is part of a specializes cycle: {}", nodes[current].filename, nodes[current].name, cycle);
+
+                depth = broken;
+            }
+
+            if (depth == broken)
+            {
+                for (size_t j = 0; j < chain.size(); ++j)
+                {
+                    if (j < loopStart)
                     {
-                        node->merge(newNode);
+                        log->error("{}: template {} can't be resolved as it specializes into a cycle", nodes[chain[j]].filename, nodes[chain[j]].name);
                     }
 
-                    db.emplace(name, newNode);
+                    nodes[chain[j]].depth = broken;
                 }
-                else
+
+                continue;
+            }
+
+            for (auto itr = chain.rbegin(); itr != chain.rend(); ++itr)
+            {
+                nodes[*itr].depth = ++depth;
+
+                levelCount = std::max(levelCount, static_cast<size_t>(depth) + 1);
+            }
+        }
+
+        // bucket every template by its depth so each parent is in the db before anything specializing it
+        std::vector<std::vector<int32_t>> levels(levelCount);
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (nodes[i].depth >= 0)
+            {
+                levels[nodes[i].depth].push_back(static_cast<int32_t>(i));
+            }
+        }
+
+        log->debug("ContentDb is resolving templates across {} levels", levels.size());
+
+        // resolving is only a few pointer assignments per template, far less than what handing it to threads would cost
+        for (size_t level = 0; level < levels.size(); ++level)
+        {
+            osg::Timer timer;
+
+            for (const int32_t i : levels[level])
+            {
+                const TmplNode& node = nodes[i];
+
+                GameObjectTmpl& tmpl = db[node.name];
+
+                tmpl.mName = node.name;
+                tmpl.mBlock = node.block;
+                tmpl.mDoc = node.doc;
+
+                // no need to copy anything from the parent, lookups will fall through to it
+                tmpl.mSuper = node.parent != -1 ? &db.find(nodes[node.parent].name)->second : nullptr;
+            }
+
+            log->debug("ContentDb resolved {} templates on level {} in {:.3f}ms", levels[level].size(), level, timer.time_m());
+        }
+
+        log->info("ContentDb loaded and resolved {} templates in {:.3f}ms", db.size(), initTimer.time_m());
+
+        // flattening every template is expensive so only do the comparison when someone is going to look at it
+        if (log->should_log(spdlog::level::debug))
+        {
+            size_t shared = 0, flattened = 0;
+
+            std::set<const Fuel*> eachDoc;
+
+            for (const auto& entry : db)
+            {
+                if (eachDoc.insert(entry.second.mDoc.get()).second)
                 {
-                    log->error("could not find {}", name);
+                    shared += blockFootprint(entry.second.mDoc.get());
                 }
+
+                flattened += blockFootprint(entry.second.flatten().get());
             }
-        };
 
-        for (const auto& entry : tmplMap)
+            log->debug("ContentDb templates are using ~{} KiB, fully flattened templates would use ~{} KiB", shared / 1024, flattened / 1024);
+        }
+    }
+
+    void ContentDb::preload(const std::vector<std::string>& names)
+    {
+        if (!lazy) return;
+
+        auto log = spdlog::get("log");
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        osg::Timer timer;
+
+        for (const auto& name : names)
         {
-            resolve(entry.first);
+            if (materialize(osgDB::convertToLowerCase(name)) == nullptr)
+            {
+                log->warn("ContentDb could not preload template {}", name);
+            }
         }
 
-        log->debug("ContentDB has finished loading and resolving {} templates", db.size());
+        log->debug("ContentDb preloaded {} templates in {:.3f}ms", names.size(), timer.time_m());
     }
 
     const std::string& ContentDb::queryString(const std::string& query, const std::string& defaultValue) const
+    {
+        if (const Attribute* attr = resolveQuery(query))
+        {
+            return attr->value;
+        }
+
+        return defaultValue;
+    }
+
+    QueryHandle ContentDb::compileQuery(const std::string& query) const
+    {
+        QueryHandle handle;
+
+        handle.mQuery = query;
+        handle.mAttr = resolveQuery(query);
+        handle.mGeneration = generation;
+
+        return handle;
+    }
+
+    const Attribute* ContentDb::resolveQuery(const std::string& query) const
     {
         if (const auto colon = query.find(':'); colon != std::string::npos)
         {
-            if (const auto itr = db.find(query.substr(0, colon)); itr != db.end())
+            std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+
+            if (lazy) lock.lock();
+
+            if (const GameObjectTmpl* tmpl = materialize(query.substr(0, colon)))
             {
-                return itr->second->valueOf(query.substr(colon + 1));
+                return tmpl->attribute(query.substr(colon + 1));
             }
         }
 
-        return defaultValue;
+        return nullptr;
+    }
+
+    const GameObjectTmpl* ContentDb::getGameObjectTmpl(const std::string& tmpl) const
+    {
+        // once init is done the db is only ever read from unless templates are being pulled in on demand
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+
+        if (lazy) lock.lock();
+
+        return materialize(tmpl);
+    }
+
+    void ContentDb::indexTemplates(const std::string& directory)
+    {
+        auto log = spdlog::get("log");
+
+        for (const auto& filename : fileSys->getFiles())
+        {
+            if (osgDB::getLowerCaseFileExtension(filename) != "gas" || filename.find(directory) != 0)
+            {
+                continue;
+            }
+
+            if (auto stream = fileSys->createInputStream(filename))
+            {
+                const std::string data(std::istreambuf_iterator<char>(*stream), {});
+
+                eachTopLevelBlock(data, [this, &log, &filename](const std::string& header, size_t offset, size_t length)
+                    {
+                        const std::string name = blockNameFromHeader(header);
+
+                        if (const auto result = index.emplace(name, SourceLocation{ filename, offset, length }); result.second != true)
+                        {
+                            log->warn("{}: duplicate entry {} found, already defined in {}", filename, name, result.first->second.filename);
+                        }
+                    });
+            }
+            else
+            {
+                log->error("{}: could not create input stream", filename);
+            }
+        }
+    }
+
+    const GameObjectTmpl* ContentDb::materialize(const std::string& name) const
+    {
+        if (const auto itr = db.find(name); itr != db.end())
+        {
+            if (itr->second.mBlock != nullptr) return &itr->second;
+
+            // a template still being materialized further down the stack means the specializes chain came back around to it
+            if (const auto start = std::find(materializing.begin(), materializing.end(), name); start != materializing.end())
+            {
+                std::string cycle;
+
+                for (auto step = start; step != materializing.end(); ++step)
+                {
+                    cycle += *step + " -> ";
+                }
+
+                cycle += name;
+
+                spdlog::get("log")->error("{}: template {} is part of a specializes cycle: {}", index.at(name).filename, name, cycle);
+            }
+
+            // otherwise it failed to load or resolve before
+            return nullptr;
+        }
+
+        if (!lazy) return nullptr;
+
+        const auto location = index.find(name);
+
+        if (location == index.end()) return nullptr;
+
+        GameObjectTmpl& tmpl = db[name];
+        tmpl.mName = name;
+
+        auto doc = loadTemplate(name, location->second);
+
+        if (doc == nullptr) return nullptr;
+
+        const FuelBlock* block = doc->eachChild().front();
+
+        // the block is only attached once the parents resolved, until then anything walking back to this template sees it unresolved
+        materializing.push_back(name);
+        link(tmpl, *block);
+        materializing.pop_back();
+
+        // a parent that exists but didn't resolve means this template can't be resolved either, the same as a full init
+        if (tmpl.mSuper == nullptr && index.count(osgDB::convertToLowerCase(block->valueOf("specializes"))) != 0)
+        {
+            return nullptr;
+        }
+
+        tmpl.mBlock = block;
+        tmpl.mDoc = std::move(doc);
+
+        return &tmpl;
+    }
+
+    std::shared_ptr<Fuel> ContentDb::loadTemplate(const std::string& name, const SourceLocation& source) const
+    {
+        auto log = spdlog::get("log");
+
+        if (auto stream = fileSys->createInputStream(source.filename))
+        {
+            std::string data(source.length, '\0');
+
+            stream->seekg(source.offset);
+            stream->read(&data[0], source.length);
+
+            std::istringstream blockStream(data);
+
+            if (auto doc = std::make_shared<Fuel>(); doc->load(blockStream) && !doc->eachChild().empty())
+            {
+                return doc;
+            }
+
+            log->error("{}: could not parse template {} at offset {}", source.filename, name, source.offset);
+        }
+        else
+        {
+            log->error("{}: could not create input stream for template {}", source.filename, name);
+        }
+
+        return nullptr;
     }
 
-    const FuelBlock* ContentDb::getGameObjectTmpl(const std::string& tmpl) const
+    void ContentDb::link(GameObjectTmpl& tmpl, const FuelBlock& block) const
     {
-        const auto itr = db.find(tmpl);
+        tmpl.mSuper = nullptr;
+
+        if (const std::string specializes = osgDB::convertToLowerCase(block.valueOf("specializes")); !specializes.empty())
+        {
+            const std::string& filename = index.count(tmpl.mName) ? index.at(tmpl.mName).filename : tmpl.mName;
 
-        return itr != db.end() ? itr->second.get() : nullptr;
+            if (index.count(specializes) == 0)
+            {
+                // same as a full init, keep the template around as a base template
+                spdlog::get("log")->error("{}: template {} specializes {} which could not be found", filename, tmpl.mName, specializes);
+            }
+            else if (tmpl.mSuper = materialize(specializes); tmpl.mSuper == nullptr)
+            {
+                spdlog::get("log")->error("{}: template {} can't be resolved as {} failed to resolve or is part of a specializes cycle", filename, tmpl.mName, specializes);
+            }
+        }
+    }
+
+    void ContentDb::reload(const std::string& filename)
+    {
+        if (fileSys == nullptr || filename.find(directory) != 0 || osgDB::getLowerCaseFileExtension(filename) != "gas")
+        {
+            return;
+        }
+
+        auto log = spdlog::get("log");
+
+        osg::Timer timer;
+
+        // a file that can't be opened anymore was deleted and takes all of its templates with it
+        std::string data;
+
+        if (auto stream = fileSys->createInputStream(filename))
+        {
+            data.assign(std::istreambuf_iterator<char>(*stream), {});
+        }
+
+        // figure out what the file contains now before touching anything so a broken edit leaves the db as it was
+        std::unordered_map<std::string, SourceLocation> current;
+        std::unordered_map<std::string, const FuelBlock*> blocks;
+        std::shared_ptr<Fuel> doc;
+
+        if (!data.empty())
+        {
+            // even when running lazily the whole file is parsed once, scanning for blocks alone would take a broken edit as an empty file
+            doc = std::make_shared<Fuel>();
+
+            if (!doc->parse(data))
+            {
+                log->error("{}: could not parse, keeping the previously loaded templates", filename);
+
+                for (const FuelDiagnostic& diagnostic : doc->diagnostics())
+                {
+                    log->error("{}:{}:{}: {}", filename, diagnostic.line, diagnostic.column, diagnostic.message);
+                }
+
+                return;
+            }
+        }
+
+        if (lazy)
+        {
+            eachTopLevelBlock(data, [&current, &filename](const std::string& header, size_t offset, size_t length)
+                {
+                    current.emplace(blockNameFromHeader(header), SourceLocation{ filename, offset, length });
+                });
+
+            // the templates are parsed again one at a time on their next use
+            doc.reset();
+        }
+        else if (doc != nullptr)
+        {
+            for (const FuelBlock* node : doc->eachChild())
+            {
+                const std::string name = osgDB::convertToLowerCase(node->name());
+
+                current.emplace(name, SourceLocation{ filename });
+                blocks.emplace(name, node);
+            }
+        }
+
+        std::vector<std::string> changed;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // who specializes who, taken before anything moves so descendants can be found from their old parents
+            std::unordered_map<const GameObjectTmpl*, std::vector<GameObjectTmpl*>> children;
+
+            for (auto& entry : db)
+            {
+                if (entry.second.mSuper != nullptr)
+                {
+                    children[entry.second.mSuper].push_back(&entry.second);
+                }
+            }
+
+            // every template that has to be linked again, parents always come before their children
+            std::vector<GameObjectTmpl*> dirty;
+            std::set<const GameObjectTmpl*> queued;
+
+            auto enqueue = [&dirty, &queued](GameObjectTmpl* tmpl)
+            {
+                if (queued.insert(tmpl).second)
+                {
+                    dirty.push_back(tmpl);
+                }
+            };
+
+            // templates deleted below, nothing is queued until they are all gone since a child can be removed along with its parent
+            std::set<const GameObjectTmpl*> erased;
+            std::vector<GameObjectTmpl*> orphans;
+
+            // drop templates that are no longer in the file, anything specializing them loses its parent
+            for (auto itr = index.begin(); itr != index.end();)
+            {
+                if (itr->second.filename == filename && current.count(itr->first) == 0)
+                {
+                    if (const auto tmpl = db.find(itr->first); tmpl != db.end())
+                    {
+                        const auto& removedChildren = children[&tmpl->second];
+
+                        orphans.insert(orphans.end(), removedChildren.begin(), removedChildren.end());
+
+                        erased.insert(&tmpl->second);
+                        db.erase(tmpl);
+                    }
+
+                    log->info("{}: template {} was removed", filename, itr->first);
+
+                    changed.push_back(itr->first);
+                    itr = index.erase(itr);
+                }
+                else
+                {
+                    ++itr;
+                }
+            }
+
+            // swap in the new blocks, templates keep their address so pointers handed out earlier stay valid
+            for (const auto& entry : current)
+            {
+                // same as a full init, the first file to define a template keeps it no matter which file was saved last
+                if (const auto existing = index.find(entry.first); existing != index.end() && existing->second.filename != filename)
+                {
+                    log->warn("{}: duplicate entry {} found, already defined in {}", filename, entry.first, existing->second.filename);
+
+                    continue;
+                }
+
+                index.insert_or_assign(entry.first, entry.second);
+
+                changed.push_back(entry.first);
+
+                if (lazy)
+                {
+                    // templates nobody has asked for yet will be picked up from the new location when they are needed
+                    const auto itr = db.find(entry.first);
+
+                    if (itr == db.end()) continue;
+
+                    // one that failed before, say as part of a cycle, gets another try on its next use
+                    if (itr->second.mBlock == nullptr)
+                    {
+                        const auto& retriedChildren = children[&itr->second];
+
+                        orphans.insert(orphans.end(), retriedChildren.begin(), retriedChildren.end());
+
+                        erased.insert(&itr->second);
+                        db.erase(itr);
+
+                        continue;
+                    }
+
+                    if (auto templateDoc = loadTemplate(entry.first, entry.second))
+                    {
+                        itr->second.mBlock = templateDoc->eachChild().front();
+                        itr->second.mDoc = std::move(templateDoc);
+                    }
+
+                    enqueue(&itr->second);
+                }
+                else
+                {
+                    GameObjectTmpl& tmpl = db[entry.first];
+
+                    tmpl.mName = entry.first;
+                    tmpl.mBlock = blocks.at(entry.first);
+                    tmpl.mDoc = doc;
+
+                    enqueue(&tmpl);
+                }
+            }
+
+            /*
+             * forget the deleted templates before following children around. a template added above can be given the address
+             * of one that was deleted but it has no children yet and was queued on its own already
+             */
+            for (auto itr = children.begin(); itr != children.end();)
+            {
+                if (erased.count(itr->first) != 0)
+                {
+                    itr = children.erase(itr);
+
+                    continue;
+                }
+
+                auto& list = itr->second;
+                list.erase(std::remove_if(list.begin(), list.end(), [&erased](const GameObjectTmpl* child) { return erased.count(child) != 0; }), list.end());
+
+                ++itr;
+            }
+
+            for (GameObjectTmpl* orphan : orphans)
+            {
+                if (erased.count(orphan) == 0)
+                {
+                    enqueue(orphan);
+                }
+            }
+
+            // pull in everything below the changed templates
+            for (size_t i = 0; i < dirty.size(); ++i)
+            {
+                if (const auto itr = children.find(dirty[i]); itr != children.end())
+                {
+                    for (GameObjectTmpl* child : itr->second)
+                    {
+                        enqueue(child);
+                    }
+                }
+            }
+
+            for (GameObjectTmpl* tmpl : dirty)
+            {
+                if (tmpl->mBlock != nullptr)
+                {
+                    link(*tmpl, *tmpl->mBlock);
+                }
+            }
+
+            // an edit can close a loop in the specializes chain, cut it where it was found so lookups can't spin forever
+            for (GameObjectTmpl* tmpl : dirty)
+            {
+                const GameObjectTmpl* itr = tmpl->mSuper;
+
+                for (size_t steps = 0; itr != nullptr && itr != tmpl && steps < db.size(); ++steps)
+                {
+                    itr = itr->mSuper;
+                }
+
+                if (itr == tmpl)
+                {
+                    log->error("{}: template {} is part of a specializes cycle, treating it as a base template", filename, tmpl->mName);
+
+                    tmpl->mSuper = nullptr;
+                }
+            }
+
+            generation++;
+
+            log->info("ContentDb reloaded {} in {:.3f}ms, {} templates were re-resolved", filename, timer.time_m(), dirty.size());
+        }
+
+        log->debug("notifying {} subscribers of {} changed templates", subscribers.size(), changed.size());
+
+        for (const auto& subscriber : subscribers)
+        {
+            subscriber.second(changed);
+        }
+    }
+
+    size_t ContentDb::subscribe(ReloadCallback callback)
+    {
+        subscribers.emplace_back(nextSubscriberId, std::move(callback));
+
+        return nextSubscriberId++;
+    }
+
+    void ContentDb::unsubscribe(size_t id)
+    {
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [id](const auto& subscriber) { return subscriber.first == id; }), subscribers.end());
     }
 }
@@ -1,8 +1,11 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <unordered_map>
 #include "gas/Fuel.hpp"
 
@@ -13,20 +16,223 @@ namespace gas
 
 namespace ehb
 {
+    /*
+     * a resolved game object template
+     *
+     * templates don't hold a merged copy of everything they specialize. each template only references the
+     * block it was declared with and lookups walk up the specializes chain until a value is found. this way
+     * actor -> humanoid -> farmgirl all share the same [aspect], [body] and [chore_dictionary] blocks
+     */
+    class GameObjectTmpl final
+    {
+        friend class ContentDb;
+
+    public:
+
+        const std::string& name() const;
+
+        //! @return the template this template specializes or nullptr if this is a base template
+        const GameObjectTmpl* specializes() const;
+
+        //! @return the block as it was declared in its gas file, without anything inherited
+        const FuelBlock* block() const;
+
+        bool hasAttr(const std::string& name) const;
+
+        //! same as FuelBlock::valueOf but will fall back to the specialized templates
+        const std::string& valueOf(const std::string& name, const std::string& defaultValue = "") const;
+        const std::string& typeOf(const std::string& name, const std::string& defaultValue = "") const;
+
+        //! create a deep copy of this template with every inherited block merged in, this is what templates used to look like in memory
+        std::unique_ptr<Fuel> flatten() const;
+
+    private:
+
+        const Attribute* attribute(const std::string& name) const;
+
+    private:
+
+        std::string mName;
+        const FuelBlock* mBlock = nullptr;
+        const GameObjectTmpl* mSuper = nullptr;
+
+        //! keeps the document mBlock lives in alive, shared by every template that came from the same parse
+        std::shared_ptr<const Fuel> mDoc;
+    };
+
+    inline const std::string& GameObjectTmpl::name() const
+    {
+        return mName;
+    }
+
+    inline const GameObjectTmpl* GameObjectTmpl::specializes() const
+    {
+        return mSuper;
+    }
+
+    inline const FuelBlock* GameObjectTmpl::block() const
+    {
+        return mBlock;
+    }
+
+    inline bool GameObjectTmpl::hasAttr(const std::string& name) const
+    {
+        return attribute(name) != nullptr;
+    }
+
+    inline const std::string& GameObjectTmpl::valueOf(const std::string& name, const std::string& defaultValue) const
+    {
+        if (const Attribute* attr = attribute(name))
+        {
+            return attr->value;
+        }
+
+        return defaultValue;
+    }
+
+    inline const std::string& GameObjectTmpl::typeOf(const std::string& name, const std::string& defaultValue) const
+    {
+        if (const Attribute* attr = attribute(name))
+        {
+            return attr->type;
+        }
+
+        return defaultValue;
+    }
+
+    /*
+     * a query that has already been resolved down to the attribute it points at
+     * handles are cheap to copy and should be compiled once then held onto by whoever is issuing the query every frame
+     */
+    class QueryHandle final
+    {
+        friend class ContentDb;
+
+    public:
+
+        QueryHandle() = default;
+
+        const std::string& query() const;
+
+    private:
+
+        //! kept around so the handle can be compiled again if the db changes underneath it
+        std::string mQuery;
+
+        //! nullptr if the template or attribute doesn't exist
+        const Attribute* mAttr = nullptr;
+
+        //! the ContentDb generation this handle was compiled against
+        uint32_t mGeneration = 0;
+    };
+
+    inline const std::string& QueryHandle::query() const
+    {
+        return mQuery;
+    }
+
     class IFileSys;
     class ContentDb final
     {
     public:
 
-        void init(IFileSys& fileSys, const std::string& directory = "/world/contentdb/templates/");
+        //! receives the name of every template that was added, changed or removed by a reload
+        using ReloadCallback = std::function<void(const std::vector<std::string>& templates)>;
+
+    public:
+
+        /*
+         * @param lazy when true only the location of each template is indexed up front and templates are
+         * parsed and resolved the first time they are looked up. this trades a bit of work on first use for a faster startup
+         */
+        void init(IFileSys& fileSys, const std::string& directory = "/world/contentdb/templates/", bool lazy = false);
+
+        //! resolve the given templates right away when running lazily so the first lookup doesn't have to
+        void preload(const std::vector<std::string>& names);
 
         //! query a string from a given template, for example: "2w_gargoyle:aspect:experience_value"
         const std::string& queryString(const std::string& query, const std::string& defaultValue = "") const;
 
-        const FuelBlock* getGameObjectTmpl(const std::string& tmpl) const;
+        //! resolve a query in the same format as queryString once so it can be looked up without any string work
+        QueryHandle compileQuery(const std::string& query) const;
+
+        /*
+         * look up a compiled query. if the db has been re-initialized or reloaded since the handle was compiled
+         * the handle gets compiled again before the lookup, otherwise this is just a pointer check
+         */
+        const std::string& queryString(QueryHandle& handle, const std::string& defaultValue = "") const;
+
+        const GameObjectTmpl* getGameObjectTmpl(const std::string& tmpl) const;
+
+        /*
+         * re-parse a single template file and re-resolve only the templates it defines and the templates that specialize them
+         * templates that are still defined keep their address, templates that were removed from the file are deleted
+         * and anything that specialized them becomes a base template. query handles are recompiled on their next use
+         */
+        void reload(const std::string& filename);
+
+        //! @return an id which can be passed to unsubscribe
+        size_t subscribe(ReloadCallback callback);
+        void unsubscribe(size_t id);
+
+    private:
+
+        //! where to find a template that hasn't been materialized yet
+        struct SourceLocation
+        {
+            std::string filename;
+            size_t offset = 0;
+            size_t length = 0;
+        };
 
     private:
 
-        std::unordered_map<std::string, std::unique_ptr<FuelBlock>> db;
+        const Attribute* resolveQuery(const std::string& query) const;
+
+        void indexTemplates(const std::string& directory);
+
+        //! parse just the block a lazily indexed template was declared with
+        std::shared_ptr<Fuel> loadTemplate(const std::string& name, const SourceLocation& source) const;
+
+        //! point a template declared by block at the template it specializes, parents have to be linked before their children
+        void link(GameObjectTmpl& tmpl, const FuelBlock& block) const;
+
+        //! find a resolved template, when running lazily this will parse and resolve the template and its parents if needed
+        const GameObjectTmpl* materialize(const std::string& name) const;
+
+    private:
+
+        IFileSys* fileSys = nullptr;
+
+        std::string directory;
+
+        bool lazy = false;
+
+        //! guards the templates while they are being materialized on demand, unused otherwise
+        mutable std::mutex mutex;
+
+        std::unordered_map<std::string, SourceLocation> index;
+
+        //! bumped every time templates are rebuilt or reloaded so outstanding query handles know they are stale
+        uint32_t generation = 0;
+
+        mutable std::unordered_map<std::string, GameObjectTmpl> db;
+
+        //! the chain of templates materialize is in the middle of, innermost last
+        mutable std::vector<std::string> materializing;
+
+        size_t nextSubscriberId = 1;
+        std::vector<std::pair<size_t, ReloadCallback>> subscribers;
     };
+
+    inline const std::string& ContentDb::queryString(QueryHandle& handle, const std::string& defaultValue) const
+    {
+        if (handle.mGeneration != generation)
+        {
+            handle.mAttr = resolveQuery(handle.mQuery);
+            handle.mGeneration = generation;
+        }
+
+        return handle.mAttr != nullptr ? handle.mAttr->value : defaultValue;
+    }
 }
@@ -0,0 +1,442 @@
+
+#include "FuelCorpus.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <sstream>
+#include <spdlog/spdlog.h>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
+#include "Fuel.hpp"
+#include "FuelBinary.hpp"
+#include "IFileSys.hpp"
+#include "Parallel.hpp"
+
+namespace ehb
+{
+    namespace
+    {
+        //! what part of a block a query term looks at
+        enum class TermKind
+        {
+            Type,
+            Name,
+            Attr
+        };
+
+        struct Term
+        {
+            TermKind kind = TermKind::Name;
+            std::string pattern;
+            bool literal = false;
+        };
+
+        //! one [ ] selector of a query, every term has to match
+        using Step = std::vector<Term>;
+
+        std::string lower(std::string_view value)
+        {
+            std::string result(value);
+
+            std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            return result;
+        }
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) value.remove_prefix(1);
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.remove_suffix(1);
+
+            return value;
+        }
+
+        /*
+         * case insensitive glob, pattern is expected to already be lowercase
+         * with path set '*' and '?' won't match a '/' but '**' will
+         */
+        bool globMatch(std::string_view pattern, std::string_view text, bool path)
+        {
+            while (!pattern.empty())
+            {
+                if (pattern.front() == '*')
+                {
+                    const bool crossDirectories = !path || (pattern.size() > 1 && pattern[1] == '*');
+
+                    pattern.remove_prefix(path && crossDirectories ? 2 : 1);
+
+                    for (size_t i = 0; ; ++i)
+                    {
+                        if (globMatch(pattern, text.substr(i), path)) return true;
+                        if (i == text.size() || (!crossDirectories && text[i] == '/')) return false;
+                    }
+                }
+
+                if (text.empty()) return false;
+
+                const char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text.front())));
+
+                if (pattern.front() == '?' ? (path && c == '/') : pattern.front() != c) return false;
+
+                pattern.remove_prefix(1);
+                text.remove_prefix(1);
+            }
+
+            return text.empty();
+        }
+
+        bool termMatch(const Term& term, FuelViewBlock block)
+        {
+            switch (term.kind)
+            {
+                case TermKind::Type: return globMatch(term.pattern, block.type(), false);
+                case TermKind::Name: return globMatch(term.pattern, block.name(), false);
+                case TermKind::Attr:
+                {
+                    for (FuelViewAttribute attr : block.eachAttribute())
+                    {
+                        if (globMatch(term.pattern, attr.name(), false)) return true;
+                    }
+
+                    return false;
+                }
+            }
+
+            return false;
+        }
+
+        bool stepMatch(const Step& step, FuelViewBlock block)
+        {
+            return std::all_of(step.begin(), step.end(), [block](const Term& term) { return termMatch(term, block); });
+        }
+
+        //! split a query into its file glob and selectors, @return false if it doesn't make sense
+        bool parseQuery(std::string_view query, std::string& fileGlob, std::vector<Step>& steps)
+        {
+            query = trim(query);
+
+            if (!query.empty() && query.front() == '/')
+            {
+                const size_t end = std::min(query.find_first_of(" \t["), query.size());
+
+                fileGlob = lower(query.substr(0, end));
+                query = trim(query.substr(end));
+            }
+
+            while (!query.empty())
+            {
+                if (query.front() != '[') return false;
+
+                const size_t end = query.find(']');
+
+                if (end == std::string_view::npos) return false;
+
+                std::string_view body = query.substr(1, end - 1);
+                Step step;
+
+                while (true)
+                {
+                    const size_t comma = body.find(',');
+                    std::string_view item = trim(body.substr(0, comma));
+
+                    Term term;
+
+                    if (item.size() > 2 && item[1] == ':')
+                    {
+                        switch (std::tolower(static_cast<unsigned char>(item[0])))
+                        {
+                            case 't': term.kind = TermKind::Type; break;
+                            case 'n': term.kind = TermKind::Name; break;
+                            case 'a': term.kind = TermKind::Attr; break;
+                            default: return false;
+                        }
+
+                        item = trim(item.substr(2));
+                    }
+
+                    if (item.empty()) return false;
+
+                    term.pattern = lower(item);
+                    term.literal = term.pattern.find_first_of("*?") == std::string::npos;
+
+                    step.push_back(std::move(term));
+
+                    if (comma == std::string_view::npos) break;
+
+                    body.remove_prefix(comma + 1);
+                }
+
+                steps.push_back(std::move(step));
+                query = trim(query.substr(end + 1));
+            }
+
+            return !steps.empty();
+        }
+
+        //! views only read binary so text gets parsed once and flattened into a buffer the view holds on to
+        std::unique_ptr<FuelView> loadView(std::string data)
+        {
+            if (!FuelBinary::isBinary(data.data(), data.size()))
+            {
+                std::istringstream textStream(data);
+                std::ostringstream binaryStream;
+
+                if (Fuel doc; !doc.load(textStream) || !doc.saveBinary(binaryStream))
+                {
+                    return nullptr;
+                }
+
+                data = binaryStream.str();
+            }
+
+            auto buffer = std::make_shared<std::string>(std::move(data));
+            auto view = std::make_unique<FuelView>();
+
+            if (!view->open(buffer->data(), buffer->size(), buffer))
+            {
+                return nullptr;
+            }
+
+            return view;
+        }
+    }
+
+    void FuelCorpus::build(IFileSys& fileSys, const std::string& directory)
+    {
+        auto log = spdlog::get("log");
+
+        osg::Timer timer;
+
+        filenames.clear();
+        documents.clear();
+        types.clear();
+        names.clear();
+        attrs.clear();
+
+        // the file system isn't safe to read from multiple threads so pull everything in up front
+        std::vector<std::string> buffers;
+
+        for (const auto& filename : fileSys.getFiles())
+        {
+            if (const std::string ext = osgDB::getLowerCaseFileExtension(filename); (ext != "gas" && ext != "gasb") || filename.find(directory) != 0)
+            {
+                continue;
+            }
+
+            if (auto stream = fileSys.createInputStream(filename))
+            {
+                filenames.push_back(filename);
+                buffers.emplace_back(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+            }
+            else
+            {
+                log->error("{}: could not create input stream", filename);
+            }
+        }
+
+        documents.resize(filenames.size());
+
+        parallelFor(filenames.size(), [this, &buffers](size_t i)
+            {
+                documents[i] = loadView(std::move(buffers[i]));
+            });
+
+        // drop anything that didn't parse so every document left in the corpus is usable
+        size_t count = 0;
+
+        for (size_t i = 0; i < documents.size(); ++i)
+        {
+            if (documents[i] == nullptr)
+            {
+                log->error("{}: could not parse", filenames[i]);
+
+                continue;
+            }
+
+            if (count != i)
+            {
+                filenames[count] = std::move(filenames[i]);
+                documents[count] = std::move(documents[i]);
+            }
+
+            index(static_cast<uint32_t>(count++));
+        }
+
+        filenames.resize(count);
+        documents.resize(count);
+
+        size_t blockCount = 0;
+
+        for (const auto& doc : documents)
+        {
+            blockCount += doc->blockCount();
+        }
+
+        log->info("FuelCorpus indexed {} files, {} blocks, {} types, {} names, {} attribute keys in {:.3f}ms", documents.size(), blockCount, types.size(), names.size(), attrs.size(), timer.time_m());
+    }
+
+    bool FuelCorpus::add(const std::string& filename, std::istream& stream)
+    {
+        auto view = loadView(std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()));
+
+        if (view == nullptr)
+        {
+            spdlog::get("log")->error("{}: could not parse", filename);
+
+            return false;
+        }
+
+        filenames.push_back(filename);
+        documents.push_back(std::move(view));
+
+        index(static_cast<uint32_t>(documents.size() - 1));
+
+        return true;
+    }
+
+    void FuelCorpus::index(uint32_t document)
+    {
+        const FuelView& view = *documents[document];
+
+        // block 0 is the document itself which has no name or type worth searching for
+        for (uint32_t i = 1; i < view.blockCount(); ++i)
+        {
+            const FuelViewBlock block = view.block(i);
+            const Posting posting = { document, i };
+
+            if (!block.type().empty())
+            {
+                types[lower(block.type())].push_back(posting);
+            }
+
+            names[lower(block.name())].push_back(posting);
+
+            for (FuelViewAttribute attr : block.eachAttribute())
+            {
+                auto& postings = attrs[lower(attr.name())];
+
+                // a key repeated inside a block only needs to point at it once
+                if (postings.empty() || postings.back().document != document || postings.back().block != i)
+                {
+                    postings.push_back(posting);
+                }
+            }
+        }
+    }
+
+    std::vector<FuelCorpus::Match> FuelCorpus::query(const std::string& query) const
+    {
+        std::string fileGlob;
+        std::vector<Step> steps;
+
+        if (!parseQuery(query, fileGlob, steps))
+        {
+            spdlog::get("log")->warn("FuelCorpus: invalid query '{}'", query);
+
+            return {};
+        }
+
+        std::vector<bool> fileMatches(documents.size(), true);
+
+        if (!fileGlob.empty())
+        {
+            for (size_t i = 0; i < documents.size(); ++i)
+            {
+                fileMatches[i] = globMatch(fileGlob, filenames[i], true);
+            }
+        }
+
+        auto postingMap = [this](TermKind kind) -> const PostingMap&
+        {
+            return kind == TermKind::Type ? types : kind == TermKind::Name ? names : attrs;
+        };
+
+        /*
+         * the first selector gets its candidates from the index, a literal term is a single lookup so the
+         * smallest of those wins. if everything is a glob the keys of the first term are scanned instead
+         */
+        const Step& first = steps.front();
+        const std::vector<Posting>* literal = nullptr;
+
+        for (const Term& term : first)
+        {
+            if (term.literal)
+            {
+                const PostingMap& map = postingMap(term.kind);
+                const auto itr = map.find(term.pattern);
+
+                if (itr == map.end()) return {};
+
+                if (literal == nullptr || itr->second.size() < literal->size())
+                {
+                    literal = &itr->second;
+                }
+            }
+        }
+
+        std::vector<Posting> globbed;
+
+        if (literal == nullptr)
+        {
+            for (const auto& entry : postingMap(first.front().kind))
+            {
+                if (globMatch(first.front().pattern, entry.first, false))
+                {
+                    globbed.insert(globbed.end(), entry.second.begin(), entry.second.end());
+                }
+            }
+
+            std::sort(globbed.begin(), globbed.end(), [](const Posting& lhs, const Posting& rhs) { return lhs.document != rhs.document ? lhs.document < rhs.document : lhs.block < rhs.block; });
+
+            // a block using several keys that match the glob was posted once for each of them
+            globbed.erase(std::unique(globbed.begin(), globbed.end(), [](const Posting& lhs, const Posting& rhs) { return lhs.document == rhs.document && lhs.block == rhs.block; }), globbed.end());
+        }
+
+        std::vector<FuelViewBlock> current;
+        std::vector<uint32_t> currentDocs;
+
+        for (const Posting& posting : literal != nullptr ? *literal : globbed)
+        {
+            if (!fileMatches[posting.document]) continue;
+
+            if (const FuelViewBlock block = documents[posting.document]->block(posting.block); stepMatch(first, block))
+            {
+                current.push_back(block);
+                currentDocs.push_back(posting.document);
+            }
+        }
+
+        // every selector after the first narrows things down to direct children
+        for (size_t s = 1; s < steps.size() && !current.empty(); ++s)
+        {
+            std::vector<FuelViewBlock> next;
+            std::vector<uint32_t> nextDocs;
+
+            for (size_t i = 0; i < current.size(); ++i)
+            {
+                for (FuelViewBlock child : current[i].eachChild())
+                {
+                    if (stepMatch(steps[s], child))
+                    {
+                        next.push_back(child);
+                        nextDocs.push_back(currentDocs[i]);
+                    }
+                }
+            }
+
+            current = std::move(next);
+            currentDocs = std::move(nextDocs);
+        }
+
+        std::vector<Match> result;
+        result.reserve(current.size());
+
+        for (size_t i = 0; i < current.size(); ++i)
+        {
+            result.push_back({ filenames[currentDocs[i]], current[i] });
+        }
+
+        return result;
+    }
+}
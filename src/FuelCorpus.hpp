@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "gas/FuelView.hpp"
+
+namespace ehb
+{
+    // every gas file under a directory loaded as FuelViews with an index of which blocks use which types, names and attribute keys
+    //
+    // queries are a file glob followed by one or more block selectors written like gas block headers:
+    //
+    //   /world/maps/*/regions/*/objects/*.gas [t:actor]        every actor block in any region's objects directory
+    //   /world/contentdb/templates/**.gas [n:*gargoyle*]       any block with gargoyle in its name
+    //   [t:template] [aspect]                                   the aspect block directly inside every template
+    //   [t:template,a:specializes]                              templates with a specializes attribute
+    //
+    // the file glob is optional, '*' stops at a '/' while '**' does not. a selector is a comma separated list of
+    // t:<type>, n:<name> and a:<attribute key>, a bare pattern is a name. the first selector matches blocks at any depth
+    // and every selector after it matches the direct children of the previous one. everything is case insensitive
+    class IFileSys;
+    class FuelCorpus final
+    {
+    public:
+
+        //! a match points into the corpus, add() keeps it valid but build() does not
+        struct Match
+        {
+            std::string_view filename;
+            FuelViewBlock block;
+        };
+
+    public:
+
+        //! load and index every gas file under directory, this replaces anything indexed before
+        void build(IFileSys& fileSys, const std::string& directory = "/");
+
+        //! add a single document to the index
+        bool add(const std::string& filename, std::istream& stream);
+
+        //! @return every block matching query in file order, an invalid query logs a warning and returns nothing
+        std::vector<Match> query(const std::string& query) const;
+
+        size_t fileCount() const;
+
+    private:
+
+        struct Posting
+        {
+            uint32_t document;
+            uint32_t block;
+        };
+
+        using PostingMap = std::unordered_map<std::string, std::vector<Posting>>;
+
+        void index(uint32_t document);
+
+    private:
+
+        //! a deque so growing it in add() doesn't move the strings Match::filename points at
+        std::deque<std::string> filenames;
+        std::vector<std::unique_ptr<FuelView>> documents;
+
+        PostingMap types;
+        PostingMap names;
+        PostingMap attrs;
+    };
+
+    inline size_t FuelCorpus::fileCount() const
+    {
+        return documents.size();
+    }
+}
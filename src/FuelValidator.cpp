@@ -0,0 +1,110 @@
+
+#include "FuelValidator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
+#include "IFileSys.hpp"
+#include "Parallel.hpp"
+
+namespace ehb
+{
+    std::vector<FuelValidator::Result> FuelValidator::validate(IFileSys& fileSys, const std::string& directory, unsigned int threadCount)
+    {
+        auto log = spdlog::get("log");
+
+        if (threadCount == 0) threadCount = defaultThreadCount();
+
+        osg::Timer timer;
+
+        std::vector<Result> results;
+        std::vector<std::string> buffers;
+
+        for (const auto& filename : fileSys.getFiles())
+        {
+            if (const std::string ext = osgDB::getLowerCaseFileExtension(filename); (ext != "gas" && ext != "gasb") || filename.find(directory) != 0)
+            {
+                continue;
+            }
+
+            if (auto stream = fileSys.createInputStream(filename))
+            {
+                results.emplace_back().filename = filename;
+                buffers.emplace_back(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+            }
+            else
+            {
+                log->error("{}: could not create input stream", filename);
+            }
+        }
+
+        const double readTime = timer.time_m();
+
+        parallelFor(results.size(), [&results, &buffers](size_t i)
+            {
+                Result& result = results[i];
+
+                osg::Timer parseTimer;
+
+                Fuel doc;
+                result.loaded = doc.parse(buffers[i]);
+                result.parseTime = parseTimer.time_m();
+                result.size = buffers[i].size();
+                result.diagnostics = doc.diagnostics();
+
+                // nothing needs the text once it's been parsed
+                std::string().swap(buffers[i]);
+            }, threadCount);
+
+        size_t failed = 0, recovered = 0, totalBytes = 0;
+        double parseTime = 0;
+
+        for (const Result& result : results)
+        {
+            for (const FuelDiagnostic& diagnostic : result.diagnostics)
+            {
+                if (diagnostic.recovered)
+                {
+                    log->warn("{}:{}:{}: {} (recovered)", result.filename, diagnostic.line, diagnostic.column, diagnostic.message);
+
+                    recovered++;
+                }
+                else
+                {
+                    log->error("{}:{}:{}: {}", result.filename, diagnostic.line, diagnostic.column, diagnostic.message);
+                }
+            }
+
+            if (!result.loaded) failed++;
+
+            totalBytes += result.size;
+            parseTime += result.parseTime;
+
+            log->debug("{}: {} bytes parsed in {:.3f}ms", result.filename, result.size, result.parseTime);
+        }
+
+        // the slowest files are where any parser work should be looking first
+        std::vector<const Result*> slowest;
+
+        for (const Result& result : results)
+        {
+            slowest.push_back(&result);
+        }
+
+        const size_t slowestCount = std::min<size_t>(slowest.size(), 5);
+
+        std::partial_sort(slowest.begin(), slowest.begin() + slowestCount, slowest.end(), [](const Result* lhs, const Result* rhs) { return lhs->parseTime > rhs->parseTime; });
+
+        for (size_t i = 0; i < slowestCount; ++i)
+        {
+            log->info("slow gas file: {} ({} KiB) took {:.3f}ms", slowest[i]->filename, slowest[i]->size / 1024, slowest[i]->parseTime);
+        }
+
+        log->info("validated {} gas files ({} KiB) in {:.3f}ms on {} threads ({:.3f}ms reading, {:.3f}ms parsing across all threads), {} failed to load, {} recovered errors",
+            results.size(), totalBytes / 1024, timer.time_m(), threadCount, readTime, parseTime, failed, recovered);
+
+        return results;
+    }
+}
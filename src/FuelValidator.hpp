@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "gas/FuelDiagnostic.hpp"
+
+namespace ehb
+{
+    class IFileSys;
+
+    //! parses every gas file under a directory and reports what is wrong with them and how long each one took
+    class FuelValidator final
+    {
+    public:
+
+        struct Result
+        {
+            std::string filename;
+            size_t size = 0;
+            double parseTime = 0; //!< milliseconds
+
+            bool loaded = false;
+            std::vector<FuelDiagnostic> diagnostics;
+        };
+
+        /*
+         * files are read on the calling thread then parsed across threadCount threads, 0 uses every core
+         * problems are logged as they'd be shown by a compiler: filename:line:column: message
+         */
+        static std::vector<Result> validate(IFileSys& fileSys, const std::string& directory = "/", unsigned int threadCount = 0);
+    };
+}
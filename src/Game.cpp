@@ -83,6 +83,12 @@ namespace ehb
 
         gameStateMgr.request("InitState");
 
+        // hot reloading only makes sense for loose files as tanks are never edited in place
+        if (config.getBool("hot-reload") && !config.getString("bits", "").empty())
+        {
+            fileWatcher = std::make_unique<FileWatcher>(config.getString("bits"));
+        }
+
         osg::Timer fps;
 
         const float maxfps = static_cast<float>(config.getInt("maxfps", -1));
@@ -93,6 +99,15 @@ namespace ehb
 
             fps.setStartTick();
 
+            // pick up any edits made to bits since the last frame
+            if (fileWatcher)
+            {
+                for (const auto& filename : fileWatcher->poll())
+                {
+                    contentDb.reload(filename);
+                }
+            }
+
             // update all systems that require an update
             gameStateMgr.update(deltaTime);
 
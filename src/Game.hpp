@@ -5,6 +5,7 @@
 #include "state/GameStateMgr.hpp"
 #include "filesystem/LocalFileSys.hpp"
 #include "filesystem/TankFileSys.hpp"
+#include "filesystem/FileWatcher.hpp"
 #include "ContentDb.hpp"
 #include "ui/Shell.hpp"
 
@@ -52,6 +53,9 @@ namespace ehb
         ContentDb contentDb;
         Shell shell;
 
+        //! only created when hot reloading is enabled
+        std::unique_ptr<FileWatcher> fileWatcher;
+
         osgViewer::Viewer viewer;
 
         osg::ref_ptr<osg::Group> scene3d;
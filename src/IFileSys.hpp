@@ -52,6 +52,11 @@ namespace ehb
                         else
                         {
                             log->error("{}: could not parse", filename);
+
+                            for (const auto& diagnostic : doc->diagnostics())
+                            {
+                                log->error("{}:{}:{}: {}", filename, diagnostic.line, diagnostic.column, diagnostic.message);
+                            }
                         }
                     }
                     else
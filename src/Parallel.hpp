@@ -0,0 +1,73 @@
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ehb
+{
+    //! @return the number of worker threads to use when a caller doesn't specify one
+    inline unsigned int defaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /*
+     * run func(index) for every index in [0, count) across threadCount threads
+     * each thread takes the next few indices from a shared counter whenever it runs out so a thread that lands on slow work
+     * doesn't hold up the rest, the calling thread is one of them and this returns once every index has finished
+     * a threadCount of 0 uses defaultThreadCount()
+     */
+    template<typename Func>
+    void parallelFor(size_t count, Func&& func, unsigned int threadCount = 0)
+    {
+        if (threadCount == 0) threadCount = defaultThreadCount();
+
+        const size_t workerCount = std::min<size_t>(threadCount, count);
+
+        if (workerCount <= 1)
+        {
+            for (size_t index = 0; index < count; ++index)
+            {
+                func(index);
+            }
+
+            return;
+        }
+
+        // small enough for the threads to even out, large enough that cheap work isn't spent fighting over the counter
+        const size_t grain = std::max<size_t>(1, count / (workerCount * 16));
+
+        std::atomic<size_t> next = 0;
+
+        auto run = [&func, &next, count, grain]()
+        {
+            for (size_t begin; (begin = next.fetch_add(grain, std::memory_order_relaxed)) < count;)
+            {
+                const size_t end = std::min(count, begin + grain);
+
+                for (size_t index = begin; index < end; ++index)
+                {
+                    func(index);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount - 1);
+
+        for (size_t worker = 1; worker < workerCount; ++worker)
+        {
+            workers.emplace_back(run);
+        }
+
+        run();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
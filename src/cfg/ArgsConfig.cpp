@@ -13,8 +13,14 @@ namespace ehb
         { // parse all boolean values from the command line
             bool value;
 
+            if (args.read("--batch-regions", value)) config.setBool("batch-regions", value);
+            if (args.read("--compact-siege-nodes", value)) config.setBool("compact-siege-nodes", value);
             if (args.read("--fullscreen", value)) config.setBool("fullscreen", value);
+            if (args.read("--hot-reload", value)) config.setBool("hot-reload", value);
             if (args.read("--intro", value)) config.setBool("intro", value);
+            if (args.read("--lazy-contentdb", value)) config.setBool("lazy-contentdb", value);
+            if (args.read("--region-benchmark", value)) config.setBool("region-benchmark", value);
+            if (args.read("--siegenode-benchmark", value)) config.setBool("siegenode-benchmark", value);
             if (args.read("--sound", value)) config.setBool("sound", value);
             if (args.read("--textures", value)) config.setBool("drawtextures", value);
         }
@@ -5,10 +5,14 @@
 #include "state/IGameStateMgr.hpp"
 #include "cfg/IConfig.hpp"
 #include "IFileSys.hpp"
+#include "FuelValidator.hpp"
 #include "StringTool.hpp"
 #include "osg/SiegeNodeMesh.hpp"
+#include "osg/FileNameMap.hpp"
+#include "osg/TextureCache.hpp"
 #include "ui/Shell.hpp"
 
+#include <osgDB/Registry>
 #include <spdlog/spdlog.h>
 
 namespace ehb
@@ -92,7 +96,7 @@ namespace ehb
             {
                 std::stringstream ss;
 
-                ss << "setstate <stateName>\nclearscene <world/gui>";
+                ss << "setstate <stateName>\nclearscene <world/gui>\ngasquery </file/glob> [t:type,n:name,a:attr] [child]\ngasvalidate [directory]\nreloadnnk\ntexturestats";
 
                 for (const auto& line : StringTool::split(ss.str(), '\n'))
                 {
@@ -236,6 +240,61 @@ namespace ehb
 
                 log->info("FINISHED FILESYSTEM DUMP");
             }
+            else if (scanner.accept("gasquery"))
+            {
+                auto log = spdlog::get("log");
+
+                if (corpus == nullptr)
+                {
+                    corpus = std::make_unique<FuelCorpus>();
+                    corpus->build(fileSys);
+                }
+
+                // the query is everything after the command, it has spaces and brackets the scanner would split on
+                const std::string query = input.substr(input.find("gasquery") + 8);
+                const auto matches = corpus->query(query);
+
+                for (const auto& match : matches)
+                {
+                    log->info("{}: [t:{},n:{}]", match.filename, match.block.type(), match.block.name());
+                }
+
+                log->info("gasquery found {} blocks", matches.size());
+            }
+            else if (scanner.accept("gasvalidate"))
+            {
+                std::string directory = "/";
+
+                if (scanner.token(first, last))
+                {
+                    directory = input.substr(first, last - first);
+                }
+
+                FuelValidator::validate(fileSys, directory);
+            }
+            else if (scanner.accept("reloadnnk"))
+            {
+                // meshes and textures being paged in keep resolving against the old table until the new one is swapped in
+                if (auto fileNameMap = dynamic_cast<FileNameMap*>(osgDB::Registry::instance()->getFindFileCallback()))
+                {
+                    fileNameMap->reload(fileSys);
+                }
+                else
+                {
+                    spdlog::get("log")->error("reloadnnk: no naming key map is registered with osg");
+                }
+            }
+            else if (scanner.accept("texturestats"))
+            {
+                TextureCache& cache = TextureCache::instance();
+
+                cache.prune();
+
+                const TextureCache::Stats stats = cache.stats();
+
+                spdlog::get("log")->info("texture cache: {} images ({} KiB, {} KiB without sharing), {} textures, {} state sets, {} of {} requests shared, {} uploads ({} KiB)",
+                    stats.images, stats.imageBytes / 1024, stats.requestedBytes / 1024, stats.textures, stats.stateSets, stats.hits, stats.requests, stats.uploads, stats.uploadBytes / 1024);
+            }
             else if (scanner.accept("activateinterface"))
             {
                 if (scanner.token(first, last))
@@ -10,6 +10,7 @@
 #include <ui/ImageFont.hpp>
 #include <osgGA/GUIEventAdapter>
 #include <osgGA/GUIActionAdapter>
+#include "FuelCorpus.hpp"
 
 namespace ehb
 {
@@ -82,6 +83,9 @@ namespace ehb
 
         ConsoleContext context;
 
+        //! built the first time gasquery is used
+        std::unique_ptr<FuelCorpus> corpus;
+
         // this mimics the behavior in the widget but contained here as Widgets rely on Shell and console is special
         // TODO: do we even need this?
         Rect rect;
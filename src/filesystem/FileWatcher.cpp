@@ -0,0 +1,113 @@
+
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <osgDB/FileNameUtils>
+
+namespace fs = std::filesystem;
+
+namespace ehb
+{
+    FileWatcher::FileWatcher(const fs::path& rootDir, std::chrono::milliseconds interval) : rootDir(rootDir), interval(interval)
+    {
+        // take the first snapshot up front so nothing that already exists is reported as a change
+        snapshot = scan();
+
+        thread = std::thread(&FileWatcher::run, this);
+
+        spdlog::get("filesystem")->info("FileWatcher is watching [{}] for changes to {} files", this->rootDir.string(), snapshot.size());
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            done = true;
+        }
+
+        wakeup.notify_one();
+        thread.join();
+    }
+
+    std::vector<std::string> FileWatcher::poll()
+    {
+        std::vector<std::string> result;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        result.swap(changed);
+
+        return result;
+    }
+
+    FileWatcher::Snapshot FileWatcher::scan() const
+    {
+        Snapshot result;
+
+        // files can disappear while iterating so every call here has to go through an error_code
+        std::error_code ec;
+
+        for (auto itr = fs::recursive_directory_iterator(rootDir, ec); !ec && itr != fs::recursive_directory_iterator(); itr.increment(ec))
+        {
+            if (itr->is_regular_file(ec))
+            {
+                if (const auto time = itr->last_write_time(ec); !ec)
+                {
+                    // relative to the root rather than cut at its length so a root given with or without a trailing '/' names files the same way
+                    result.emplace(osgDB::convertToLowerCase("/" + itr->path().lexically_relative(rootDir).generic_string()), time);
+                }
+            }
+        }
+
+        if (ec)
+        {
+            spdlog::get("filesystem")->warn("FileWatcher::scan(): {}", ec.message());
+        }
+
+        return result;
+    }
+
+    void FileWatcher::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!wakeup.wait_for(lock, interval, [this] { return done; }))
+        {
+            // don't hold up poll while walking the directory
+            lock.unlock();
+
+            Snapshot current = scan();
+            std::vector<std::string> result;
+
+            for (const auto& entry : current)
+            {
+                if (const auto itr = snapshot.find(entry.first); itr == snapshot.end() || itr->second != entry.second)
+                {
+                    result.push_back(entry.first);
+                }
+            }
+
+            for (const auto& entry : snapshot)
+            {
+                if (current.count(entry.first) == 0)
+                {
+                    result.push_back(entry.first);
+                }
+            }
+
+            snapshot = std::move(current);
+
+            lock.lock();
+
+            for (auto& filename : result)
+            {
+                if (std::find(changed.begin(), changed.end(), filename) == changed.end())
+                {
+                    changed.push_back(std::move(filename));
+                }
+            }
+        }
+    }
+}
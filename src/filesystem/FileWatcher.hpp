@@ -0,0 +1,63 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ehb
+{
+    /*
+     * watches a directory on disk (usually bits) for files being added, modified or removed
+     * the directory is scanned on a background thread so the main loop only ever has to pick up the results
+     */
+    class FileWatcher final
+    {
+    public:
+
+        //! @param interval how long to wait between scans of the directory
+        FileWatcher(const std::filesystem::path& rootDir, std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        /*
+         * @return every file that changed since the last call, in the same format IFileSys uses ("/world/contentdb/templates/foo.gas")
+         * this doesn't block and returns an empty list when nothing changed
+         */
+        std::vector<std::string> poll();
+
+    private:
+
+        using Snapshot = std::unordered_map<std::string, std::filesystem::file_time_type>;
+
+        Snapshot scan() const;
+
+        void run();
+
+    private:
+
+        std::filesystem::path rootDir;
+        std::chrono::milliseconds interval;
+
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        bool done = false;
+
+        //! only touched by the watcher thread
+        Snapshot snapshot;
+
+        //! filled by the watcher thread and drained by poll
+        std::vector<std::string> changed;
+
+        std::thread thread;
+    };
+}
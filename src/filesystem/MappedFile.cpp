@@ -0,0 +1,107 @@
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ehb
+{
+#ifdef _WIN32
+    bool MappedFile::open(const std::string& filename)
+    {
+        close();
+
+        mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (mFile == INVALID_HANDLE_VALUE)
+        {
+            mFile = nullptr;
+
+            return false;
+        }
+
+        LARGE_INTEGER size;
+
+        // empty files can't be mapped but are still valid files
+        if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+        {
+            close();
+
+            return false;
+        }
+
+        mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mMapping == nullptr)
+        {
+            close();
+
+            return false;
+        }
+
+        mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        mSize = static_cast<size_t>(size.QuadPart);
+
+        if (mData == nullptr)
+        {
+            close();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (mData != nullptr) UnmapViewOfFile(mData);
+        if (mMapping != nullptr) CloseHandle(mMapping);
+        if (mFile != nullptr) CloseHandle(mFile);
+
+        mData = nullptr;
+        mSize = 0;
+        mMapping = nullptr;
+        mFile = nullptr;
+    }
+#else
+    bool MappedFile::open(const std::string& filename)
+    {
+        close();
+
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+
+        if (fd == -1) return false;
+
+        struct stat info;
+
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            if (void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED)
+            {
+                mData = static_cast<const char*>(data);
+                mSize = static_cast<size_t>(info.st_size);
+            }
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+
+        return mData != nullptr;
+    }
+
+    void MappedFile::close()
+    {
+        if (mData != nullptr) munmap(const_cast<char*>(mData), mSize);
+
+        mData = nullptr;
+        mSize = 0;
+    }
+#endif
+}
@@ -0,0 +1,54 @@
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace ehb
+{
+    /*
+     * a read-only memory mapping of a file on disk
+     * this only works for loose files, anything inside a tank has to be read through IFileSys
+     */
+    class MappedFile final
+    {
+    public:
+
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+
+        const char* data() const;
+        size_t size() const;
+
+    private:
+
+        const char* mData = nullptr;
+        size_t mSize = 0;
+
+#ifdef _WIN32
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+#endif
+    };
+
+    inline MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    inline const char* MappedFile::data() const
+    {
+        return mData;
+    }
+
+    inline size_t MappedFile::size() const
+    {
+        return mSize;
+    }
+}
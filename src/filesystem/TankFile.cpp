@@ -462,6 +462,14 @@ void TankFile::seekAbsoluteOffset(const size_t offsetInBytes)
 	}
 }
 
+void TankFile::readBytesAt(const size_t offsetInBytes, void * buffer, const size_t numBytes)
+{
+	std::lock_guard<std::mutex> lock(fileMutex);
+
+	seekAbsoluteOffset(offsetInBytes);
+	readBytes(buffer, numBytes);
+}
+
 void TankFile::readBytes(void * buffer, const size_t numBytes)
 {
 	assert(buffer   != nullptr);
@@ -17,6 +17,7 @@
 #include <fstream>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 // this has the FourCC class
@@ -574,6 +575,9 @@ private:
 	void readAndValidateHeader();
 	void seekAbsoluteOffset(size_t offsetInBytes);
 
+	// Seek and read as one step so resources can be extracted from several threads at once.
+	void readBytesAt(size_t offsetInBytes, void * buffer, size_t numBytes);
+
 	void           readBytes(void * buffer, size_t numBytes);
 	uint16_t       readU16();
 	uint32_t       readU32();
@@ -587,6 +591,7 @@ private:
 
 	using OpenMode = std::ios_base::openmode;
 	std::ifstream  file;
+	std::mutex     fileMutex;
 	std::string    fileName;
 	Header         fileHeader;
 	OpenMode       fileOpenMode;
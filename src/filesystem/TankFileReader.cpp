@@ -414,9 +414,8 @@ ByteArray TankFile::Reader::extractResourceToMemory(TankFile & tank, const std::
 		// a few empty uncompressed dummy files. This check handles those.
 		if (fileSize != 0)
 		{
-			tank.seekAbsoluteOffset(dataOffset + fileOffset);
 			fileContents.resize(fileSize);
-			tank.readBytes(fileContents.data(), fileContents.size());
+			tank.readBytesAt(dataOffset + fileOffset, fileContents.data(), fileContents.size());
 		}
 	}
 	else // LZO/Zlib compressed:
@@ -440,9 +439,8 @@ ByteArray TankFile::Reader::extractResourceToMemory(TankFile & tank, const std::
 			// be stored without compression. So this check is necessary.
 			if (chunk.isCompressed())
 			{
-				tank.seekAbsoluteOffset(dataOffset + fileOffset + chunk.offset);
 				compressedData.resize(chunk.compressedSize + chunk.extraBytes);
-				tank.readBytes(compressedData.data(), compressedData.size());
+				tank.readBytesAt(dataOffset + fileOffset + chunk.offset, compressedData.data(), compressedData.size());
 
 				uncompressedData.resize(chunk.uncompressedSize + chunk.extraBytes);
 				uncompressedLen = static_cast<unsigned long>(uncompressedData.size());
@@ -467,9 +465,8 @@ ByteArray TankFile::Reader::extractResourceToMemory(TankFile & tank, const std::
 				compressedData.clear();
 				assert(chunk.uncompressedSize == chunk.compressedSize);
 
-				tank.seekAbsoluteOffset(dataOffset + fileOffset + chunk.offset);
 				uncompressedData.resize(chunk.uncompressedSize);
-				tank.readBytes(uncompressedData.data(), uncompressedData.size());
+				tank.readBytesAt(dataOffset + fileOffset + chunk.offset, uncompressedData.data(), uncompressedData.size());
 
 				uncompressedLen = static_cast<unsigned long>(uncompressedData.size());
 			}
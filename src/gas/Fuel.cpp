@@ -24,6 +24,7 @@
 #include <fstream>
 #include <sstream>
 #include <cctype>
+#include "FuelBinary.hpp"
 #include "FuelParser.hpp"
 #include "FuelScanner.hpp"
 
@@ -551,6 +552,76 @@ namespace ehb
         }
     }
 
+    void FuelBlock::absorb(std::unique_ptr<FuelBlock> && source)
+    {
+        if (source)
+        {
+            splice(*source);
+
+            source.reset();
+        }
+    }
+
+    void FuelBlock::integrate(std::unique_ptr<FuelBlock> && source)
+    {
+        absorb(std::move(source));
+    }
+
+    void FuelBlock::splice(FuelBlock & source)
+    {
+        // this mirrors merge(FuelBlock *) so both produce the same tree
+        mName = std::move(source.mName);
+        mType = std::move(source.mType);
+
+        if (source.isEmpty()) return;
+
+        for (FuelBlock *& i : source.mChildren)
+        {
+            bool found = false;
+
+            for (FuelBlock * j : mChildren)
+            {
+                // gas files can have wildcard blocks so make sure we don't overwrite them
+                if (i->name() == j->name() && i->name() != "*")
+                {
+                    found = true;
+                    j->splice(*i);
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                // hand the whole sub tree over, source no longer owns it
+                i->mParent = this;
+                mChildren.push_back(i);
+                i = nullptr;
+            }
+        }
+
+        for (Attribute & i : source.mAttributes)
+        {
+            bool found = false;
+
+            for (Attribute & j : mAttributes)
+            {
+                if (i.name == j.name)
+                {
+                    found = true;
+                    j = std::move(i);
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                mAttributes.push_back(std::move(i));
+            }
+        }
+
+        source.mAttributes.clear();
+    }
+
     const Attribute * FuelBlock::attribute(const std::string & name) const
     {
         const auto index = name.find_last_of(':');
@@ -587,15 +658,50 @@ namespace ehb
     {
         const std::string data(std::istreambuf_iterator<char>(stream), {});
 
-        FuelScanner scanner(data.c_str());
-        FuelParser parser(scanner, this);
+        return parse(data);
+    }
+
+    bool Fuel::parse(const std::string & data) noexcept
+    {
+        mDiagnostics.clear();
+
+        try
+        {
+            // binary documents skip the scanner and parser entirely
+            if (FuelBinary::isBinary(data.data(), data.size()))
+            {
+                if (FuelBinary::read(data.data(), data.size(), *this)) return true;
+
+                mDiagnostics.emplace_back();
+                mDiagnostics.back().message = "invalid binary fuel document";
+
+                return false;
+            }
+
+            FuelScanner scanner(data.c_str(), &mDiagnostics);
+            FuelParser parser(scanner, this);
 
-        return parser.parse() == 0;
+            return parser.parse() == 0;
+        }
+        catch (const std::exception & e)
+        {
+            // running out of memory is about all that can end up here
+            try
+            {
+                mDiagnostics.emplace_back();
+                mDiagnostics.back().message = e.what();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        return false;
     }
 
     bool Fuel::load(const std::string & filename)
     {
-        std::ifstream stream(filename);
+        std::ifstream stream(filename, std::ios_base::binary);
 
         return load(stream);
     }
@@ -622,7 +728,15 @@ namespace ehb
             level++;
             for (unsigned int i = 0; i < node->valueCount(); i++)
             {
-                stream << indent() << node->nameOf(i) << " = " << node->valueOf(i) << ";" << std::endl;
+                // keep the type so the text can be read back into exactly the same tree
+                if (node->typeOf(i) != "")
+                {
+                    stream << indent() << node->typeOf(i) << " " << node->nameOf(i) << " = " << node->valueOf(i) << ";" << std::endl;
+                }
+                else
+                {
+                    stream << indent() << node->nameOf(i) << " = " << node->valueOf(i) << ";" << std::endl;
+                }
             }
 
             for (FuelBlock * child : node->eachChild())
@@ -655,6 +769,11 @@ namespace ehb
         return true;
     }
 
+    bool Fuel::saveBinary(std::ostream & stream) const
+    {
+        return FuelBinary::write(*this, stream);
+    }
+
     bool Fuel::save(const std::string & filename) const
     {
         std::ofstream stream(filename);
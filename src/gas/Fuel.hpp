@@ -21,11 +21,13 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <array>
 #include <osg/Vec3>
 #include <osg/Vec4>
+#include "FuelDiagnostic.hpp"
 //#include "SiegeRot.hpp"
 //#include "SiegePos.hpp"
 
@@ -42,9 +44,12 @@ namespace ehb
     // main element to make use of in this api
     class FuelBlock
     {
+        // templates resolve their attributes across several blocks
+        friend class GameObjectTmpl;
+
         public:
 
-           ~FuelBlock();
+            virtual ~FuelBlock();
 
             FuelBlock * parent() const;
 
@@ -117,7 +122,7 @@ namespace ehb
             //SiegePos valueAsSiegePos(const std::string & name, const SiegePos & defaultValue = { 0.0, 0.0, 0.0, 0 }) const;
 
             /**
-             * merge the contents of this node into the result node
+             * merge the contents of this node into the result node, this node is left untouched
              * NOTE: empty children from this node will entirely overwrite
              * (including all attributes and grand children nodes) children of
              * the same name in the result node
@@ -130,6 +135,17 @@ namespace ehb
              */
             void integrate(FuelBlock * source);
 
+            /**
+             * merge source into this node and destroy it, the opposite direction of merge(FuelBlock *)
+             * this gives the same result as source->merge(this) but children that are missing
+             * from this node are moved over instead of cloned and attribute strings are moved as well
+             * so merging a temporary document doesn't allocate a second copy of it
+             */
+            void absorb(std::unique_ptr<FuelBlock> && source);
+
+            //! same as absorb, kept for symmetry with integrate(FuelBlock *)
+            void integrate(std::unique_ptr<FuelBlock> && source);
+
             void write(std::ostream & stream) const;
 
         protected:
@@ -143,6 +159,9 @@ namespace ehb
 
             const Attribute * attribute(const std::string & name) const;
 
+            //! moves everything out of source, source is left for its owner to delete
+            void splice(FuelBlock & source);
+
         private:
 
             std::string mName;
@@ -263,11 +282,32 @@ namespace ehb
     {
         public:
 
+            //! load either a text gas document or a binary fuel (.gasb) document, the format is picked from the header
             bool load(std::istream & stream);
             bool load(const std::string & filename);
 
+            /*
+             * load a document that is already in memory, this is what both load functions end up calling
+             * nothing is thrown or printed, anything wrong with the document is left in diagnostics()
+             */
+            bool parse(const std::string & data) noexcept;
+
+            //! @return every problem found by the last load, a document can load and still have recovered errors
+            const std::vector<FuelDiagnostic> & diagnostics() const;
+
             bool save(std::ostream & stream) const;
             bool save(const std::string & filename) const;
 
+            //! write the document as binary fuel, see FuelBinary.hpp for the layout
+            bool saveBinary(std::ostream & stream) const;
+
+        private:
+
+            std::vector<FuelDiagnostic> mDiagnostics;
     };
+
+    inline const std::vector<FuelDiagnostic> & Fuel::diagnostics() const
+    {
+        return mDiagnostics;
+    }
 }
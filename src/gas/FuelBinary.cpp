@@ -0,0 +1,301 @@
+
+#include "FuelBinary.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "Fuel.hpp"
+
+namespace ehb
+{
+    namespace
+    {
+        //! builds up the tables while walking a tree so they can be written in one go
+        struct Writer
+        {
+            std::vector<std::string> strings;
+            std::unordered_map<std::string, uint32_t> stringIndex;
+
+            std::vector<gasb::BlockRecord> blocks;
+            std::vector<gasb::AttrRecord> attrs;
+
+            uint32_t intern(const std::string& value)
+            {
+                if (const auto itr = stringIndex.find(value); itr != stringIndex.end())
+                {
+                    return itr->second;
+                }
+
+                const uint32_t index = static_cast<uint32_t>(strings.size());
+
+                strings.push_back(value);
+                stringIndex.emplace(value, index);
+
+                return index;
+            }
+
+            void add(const FuelBlock& node, uint32_t parent)
+            {
+                const uint32_t index = static_cast<uint32_t>(blocks.size());
+
+                gasb::BlockRecord block = {};
+                block.name = intern(node.name());
+                block.type = intern(node.type());
+                block.parent = parent;
+                block.firstAttr = static_cast<uint32_t>(attrs.size());
+                block.attrCount = node.valueCount();
+
+                blocks.push_back(block);
+
+                for (const Attribute& attr : node.eachAttribute())
+                {
+                    gasb::AttrRecord record = {};
+                    record.name = intern(attr.name);
+                    record.type = intern(attr.type);
+                    record.value = intern(attr.value);
+
+                    decode(attr, record);
+
+                    attrs.push_back(record);
+                }
+
+                for (const FuelBlock* child : node.eachChild())
+                {
+                    add(*child, index);
+                }
+
+                blocks[index].end = static_cast<uint32_t>(blocks.size());
+            }
+
+            //! only store a decoded value if the whole string converts, anything else stays a plain string
+            static void decode(const Attribute& attr, gasb::AttrRecord& record)
+            {
+                const std::string& value = attr.value;
+
+                if (value.empty()) return;
+
+                if (value.size() == 4 && std::equal(value.begin(), value.end(), "true", [](char a, char b) { return std::tolower(a) == b; }))
+                {
+                    record.kind = gasb::ValueKind::Bool;
+                    record.i = 1;
+
+                    return;
+                }
+
+                if (value.size() == 5 && std::equal(value.begin(), value.end(), "false", [](char a, char b) { return std::tolower(a) == b; }))
+                {
+                    record.kind = gasb::ValueKind::Bool;
+                    record.i = 0;
+
+                    return;
+                }
+
+                const char* begin = value.c_str();
+                const char* end = begin + value.size();
+                char* next = nullptr;
+
+                errno = 0;
+
+                if (const long result = std::strtol(begin, &next, attr.type == "x" ? 16 : 10); next == end && errno == 0 && result >= INT32_MIN && result <= INT32_MAX)
+                {
+                    record.kind = gasb::ValueKind::Int;
+                    record.i = static_cast<int32_t>(result);
+
+                    return;
+                }
+
+                // hex values are never read as floats
+                if (attr.type == "x") return;
+
+                float values[4];
+                uint8_t count = 0;
+
+                for (const char* itr = begin; count < 4; ++itr)
+                {
+                    values[count++] = std::strtof(itr, &next);
+
+                    if (next == itr) return;
+
+                    while (*next == ' ' || *next == '\t') ++next;
+
+                    if (next == end) break;
+                    if (*next != ',') return;
+
+                    itr = next;
+                }
+
+                if (next != end) return;
+
+                record.kind = count == 1 ? gasb::ValueKind::Float : gasb::ValueKind::FloatList;
+                record.count = count;
+
+                std::memcpy(record.f, values, sizeof(float) * count);
+            }
+        };
+
+        template <typename T>
+        void writeTable(std::ostream& stream, const std::vector<T>& table)
+        {
+            if (!table.empty())
+            {
+                stream.write(reinterpret_cast<const char*>(table.data()), sizeof(T) * table.size());
+            }
+        }
+    }
+
+    bool FuelBinary::isBinary(const char* data, size_t size)
+    {
+        return size >= sizeof(gasb::Header) && std::memcmp(data, gasb::magic, sizeof(gasb::magic)) == 0;
+    }
+
+    bool FuelBinary::validate(const char* data, size_t size)
+    {
+        if (!isBinary(data, size)) return false;
+
+        // the tables are read in place so the buffer has to be aligned like a fresh allocation or mapping would be
+        if (reinterpret_cast<uintptr_t>(data) % alignof(gasb::AttrRecord) != 0) return false;
+
+        gasb::Header header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.version != gasb::version || header.byteOrder != gasb::byteOrder || header.stringCount == 0 || header.blockCount == 0) return false;
+
+        // work in 64 bits so a hostile header can't wrap the size checks
+        const uint64_t offsetsStart = sizeof(gasb::Header);
+        const uint64_t stringsStart = offsetsStart + (uint64_t(header.stringCount) + 1) * sizeof(uint32_t);
+        const uint64_t blocksStart = stringsStart + ((uint64_t(header.stringBytes) + 3) & ~uint64_t(3));
+        const uint64_t attrsStart = blocksStart + uint64_t(header.blockCount) * sizeof(gasb::BlockRecord);
+        const uint64_t total = attrsStart + uint64_t(header.attrCount) * sizeof(gasb::AttrRecord);
+
+        if (total > size) return false;
+
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + offsetsStart);
+        const char* strings = data + stringsStart;
+
+        if (offsets[header.stringCount] != header.stringBytes) return false;
+
+        for (uint32_t i = 0; i < header.stringCount; ++i)
+        {
+            // every string has to end with its terminator before the next one starts
+            if (offsets[i] >= offsets[i + 1] || strings[offsets[i + 1] - 1] != '\0') return false;
+        }
+
+        const gasb::BlockRecord* blocks = reinterpret_cast<const gasb::BlockRecord*>(data + blocksStart);
+
+        for (uint32_t i = 0; i < header.blockCount; ++i)
+        {
+            const gasb::BlockRecord& block = blocks[i];
+
+            if (block.name >= header.stringCount || block.type >= header.stringCount) return false;
+            if (block.end <= i || block.end > header.blockCount) return false;
+            if (uint64_t(block.firstAttr) + block.attrCount > header.attrCount) return false;
+
+            // children have to sit entirely inside their parent
+            if (i == 0 ? block.parent != gasb::none || block.end != header.blockCount : block.parent >= i || i >= blocks[block.parent].end || block.end > blocks[block.parent].end) return false;
+        }
+
+        const gasb::AttrRecord* attrs = reinterpret_cast<const gasb::AttrRecord*>(data + attrsStart);
+
+        for (uint32_t i = 0; i < header.attrCount; ++i)
+        {
+            const gasb::AttrRecord& attr = attrs[i];
+
+            if (attr.name >= header.stringCount || attr.type >= header.stringCount || attr.value >= header.stringCount) return false;
+            if (attr.kind > gasb::ValueKind::FloatList || attr.count > 4) return false;
+        }
+
+        return true;
+    }
+
+    bool FuelBinary::write(const FuelBlock& node, std::ostream& stream)
+    {
+        Writer writer;
+
+        // the empty string is always index 0 so untyped blocks and attributes all point at the same entry
+        writer.intern("");
+        writer.add(node, gasb::none);
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(writer.strings.size() + 1);
+
+        uint32_t stringBytes = 0;
+
+        for (const std::string& value : writer.strings)
+        {
+            offsets.push_back(stringBytes);
+            stringBytes += static_cast<uint32_t>(value.size()) + 1;
+        }
+
+        offsets.push_back(stringBytes);
+
+        gasb::Header header = {};
+        std::memcpy(header.magic, gasb::magic, sizeof(gasb::magic));
+        header.version = gasb::version;
+        header.byteOrder = gasb::byteOrder;
+        header.stringCount = static_cast<uint32_t>(writer.strings.size());
+        header.stringBytes = stringBytes;
+        header.blockCount = static_cast<uint32_t>(writer.blocks.size());
+        header.attrCount = static_cast<uint32_t>(writer.attrs.size());
+
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        writeTable(stream, offsets);
+
+        for (const std::string& value : writer.strings)
+        {
+            stream.write(value.c_str(), value.size() + 1);
+        }
+
+        const char padding[4] = {};
+        stream.write(padding, (4 - stringBytes % 4) % 4);
+
+        writeTable(stream, writer.blocks);
+        writeTable(stream, writer.attrs);
+
+        return stream.good();
+    }
+
+    bool FuelBinary::read(const char* data, size_t size, FuelBlock& result)
+    {
+        if (!validate(data, size)) return false;
+
+        gasb::Header header;
+        std::memcpy(&header, data, sizeof(header));
+
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + sizeof(gasb::Header));
+        const char* strings = reinterpret_cast<const char*>(offsets + header.stringCount + 1);
+        const gasb::BlockRecord* blocks = reinterpret_cast<const gasb::BlockRecord*>(strings + ((header.stringBytes + 3) & ~3u));
+        const gasb::AttrRecord* attrs = reinterpret_cast<const gasb::AttrRecord*>(blocks + header.blockCount);
+
+        auto string = [strings, offsets](uint32_t index)
+        {
+            return std::string(strings + offsets[index], offsets[index + 1] - offsets[index] - 1);
+        };
+
+        // blocks are depth first so the node for each parent is always created before its children
+        std::vector<FuelBlock*> nodes(header.blockCount);
+        nodes[0] = &result;
+
+        for (uint32_t i = 0; i < header.blockCount; ++i)
+        {
+            const gasb::BlockRecord& block = blocks[i];
+
+            if (i != 0)
+            {
+                nodes[i] = block.type != 0 ? nodes[block.parent]->appendChild(string(block.name), string(block.type)) : nodes[block.parent]->appendChild(string(block.name));
+            }
+
+            for (uint32_t a = block.firstAttr; a < block.firstAttr + block.attrCount; ++a)
+            {
+                nodes[i]->appendValue(string(attrs[a].name), string(attrs[a].type), string(attrs[a].value));
+            }
+        }
+
+        return true;
+    }
+}
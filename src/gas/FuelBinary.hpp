@@ -0,0 +1,112 @@
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace ehb
+{
+    /*
+     * binary fuel (.gasb) layout, every table is 4 byte aligned
+     *
+     * the tables are the in memory structs written out as they are so FuelView can use a file without decoding it, which
+     * makes them host endian. the header records the byte order of the machine that wrote it and a file from a machine
+     * with the other byte order fails validation rather than being read back scrambled
+     *
+     *   Header
+     *   uint32_t stringOffsets[stringCount + 1]    offset of each string into the string data, the last entry is the total size
+     *   char stringData[]                          every string is null terminated, padded out to a multiple of 4
+     *   BlockRecord blocks[blockCount]             depth first order, block 0 is the document itself
+     *   AttrRecord attrs[attrCount]                grouped by block in the same order as the blocks
+     *
+     * since blocks are stored depth first the children of a block are block + 1 up to its end, skipping over each child's own end
+     * this lets both the tree loader and FuelView walk a document without any pointers being stored in the file
+     */
+    namespace gasb
+    {
+        constexpr char magic[4] = { 'G', 'A', 'S', 'B' };
+        constexpr uint32_t version = 2;
+
+        //! written in the byte order of the host, reads back as something else on a host with the other byte order
+        constexpr uint32_t byteOrder = 0x01020304;
+
+        //! marks the parent of the document block
+        constexpr uint32_t none = 0xffffffff;
+
+        struct Header
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t stringCount;
+            uint32_t stringBytes;
+            uint32_t blockCount;
+            uint32_t attrCount;
+            uint32_t byteOrder;
+            uint32_t reserved;
+        };
+
+        struct BlockRecord
+        {
+            uint32_t name;
+            uint32_t type;
+            uint32_t parent;
+            uint32_t end;
+            uint32_t firstAttr;
+            uint32_t attrCount;
+        };
+
+        //! what the value of an attribute was decoded to when it was written
+        enum class ValueKind : uint8_t
+        {
+            String,
+            Bool,
+            Int,
+            Float,
+            FloatList
+        };
+
+        struct AttrRecord
+        {
+            uint32_t name;
+            uint32_t type;
+            uint32_t value;
+
+            ValueKind kind;
+            uint8_t count; //!< number of floats stored when kind is FloatList
+            uint16_t reserved;
+
+            //! the decoded value, the original text is always kept in value so nothing is lost going back to text
+            union
+            {
+                int32_t i;
+                float f[4];
+            };
+        };
+
+        static_assert(sizeof(Header) == 32, "gasb header must be 32 bytes");
+        static_assert(sizeof(BlockRecord) == 24, "gasb block records must be 24 bytes");
+        static_assert(sizeof(AttrRecord) == 32, "gasb attribute records must be 32 bytes");
+    }
+
+    class FuelBlock;
+    class FuelBinary final
+    {
+    public:
+
+        //! @return true if data starts with a binary fuel header
+        static bool isBinary(const char* data, size_t size);
+
+        /*
+         * make sure data is a complete, 4 byte aligned binary fuel document with every index in range
+         * this is all the validation FuelView does so anything passing this can be walked safely
+         */
+        static bool validate(const char* data, size_t size);
+
+        //! write node and everything below it, node itself becomes the document block
+        static bool write(const FuelBlock& node, std::ostream& stream);
+
+        //! append the attributes and children of the document block in data to result
+        static bool read(const char* data, size_t size, FuelBlock& result);
+    };
+}
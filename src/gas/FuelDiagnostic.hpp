@@ -0,0 +1,45 @@
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ehb
+{
+    //! a problem found while loading a gas document
+    struct FuelDiagnostic
+    {
+        size_t offset = 0; //!< byte offset into the document
+        unsigned int line = 1;
+        unsigned int column = 1; //!< counted in bytes
+
+        std::string message;
+
+        //! the parser skipped past the problem and carried on with the rest of the document
+        bool recovered = false;
+
+        //! fill in offset, line and column for position inside document
+        void locate(std::string_view document, size_t position);
+    };
+
+    inline void FuelDiagnostic::locate(std::string_view document, size_t position)
+    {
+        offset = position;
+        line = 1;
+        column = 1;
+
+        for (size_t i = 0; i < position && i < document.size(); ++i)
+        {
+            if (document[i] == '\n')
+            {
+                line++;
+                column = 1;
+            }
+            else
+            {
+                column++;
+            }
+        }
+    }
+}
@@ -579,6 +579,7 @@ namespace  ehb  {
         node = node->parent();
 
         // account for rogue characters found in gpg gas file
+        scanner.recovered();
         yyerrok;
     }
     break;
@@ -1003,13 +1004,12 @@ namespace  ehb  {
 
 
 
-#include <iostream>
-
 namespace ehb
 {
     void FuelParser::error(const std::string & msg)
     {
-        // TODO: don't print this to cerr, but somewhere else user defined
-        std::cerr << msg << std::endl;
+        const std::string_view token = scanner.lastToken();
+
+        scanner.report(token.empty() ? msg + " at end of document" : msg + " near '" + std::string(token) + "'");
     }
 }
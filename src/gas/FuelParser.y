@@ -64,6 +64,7 @@ element
         node = node->parent();
 
         // account for rogue characters found in gpg gas file
+        scanner.recovered();
         yyerrok;
     }
     ;
@@ -131,13 +132,12 @@ identifier
 
 %%
 
-#include <iostream>
-
 namespace ehb
 {
     void FuelParser::error(const std::string & msg)
     {
-        // TODO: don't print this to cerr, but somewhere else user defined
-        std::cerr << msg << std::endl;
+        const std::string_view token = scanner.lastToken();
+
+        scanner.report(token.empty() ? msg + " at end of document" : msg + " near '" + std::string(token) + "'");
     }
 }
@@ -0,0 +1,148 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "FuelPreScanner.hpp"
+
+/*
+ * shared by every FuelPreScanner implementation, this is only included by the FuelPreScanner sources
+ *
+ * the AVX2 kernels live in their own translation unit which is built with AVX2 enabled. everything the kernels use
+ * is in an unnamed namespace so none of it can be merged at link time with a copy compiled for the wrong cpu
+ */
+namespace ehb
+{
+    struct FuelPreScanKernels
+    {
+        FuelPreScanner::Isa isa;
+
+        const char * (*skipWhitespace)(const char *, const char *);
+        const char * (*findIdentifierEnd)(const char *, const char *);
+        const char * (*findLineEnd)(const char *, const char *);
+        const char * (*findExpressionEnd)(const char *, const char *);
+        const char * (*findStringEnd)(const char *, const char *);
+        const char * (*findEmbeddedEnd)(const char *, const char *);
+    };
+
+    //! @return nullptr when the build wasn't able to compile the AVX2 kernels
+    const FuelPreScanKernels * avx2PreScanKernels();
+
+    namespace
+    {
+        inline unsigned int firstBit(uint64_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return index;
+#else
+            return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+        }
+
+        // the byte classes, the vector versions below have to match these exactly
+        inline bool whitespaceByte(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+        inline bool identifierByte(char c) { return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_' || c == '-' || c == '*' || c == '.'; }
+        inline bool lineEndByte(char c) { return c == '\r' || c == '\n'; }
+        inline bool expressionStopByte(char c) { return c == ';' || c == '"' || c == '[' || c == '/'; }
+        inline bool stringStopByte(char c) { return c == '"' || c == '\\'; }
+        inline bool embeddedStopByte(char c) { return c == ']' || c == '/'; }
+
+        //! a one byte "vector" so the scalar kernels come out of the same definitions as the real ones
+        struct ScalarOps
+        {
+            static constexpr size_t width = 1;
+            static constexpr unsigned int bitsPerByte = 1;
+            static constexpr uint64_t full = 1;
+
+            static uint8_t load(const char * data) { return static_cast<uint8_t>(*data); }
+            static uint8_t splat(char c) { return static_cast<uint8_t>(c); }
+            static uint8_t eq(uint8_t x, char c) { return x == splat(c); }
+            static uint8_t either(uint8_t a, uint8_t b) { return a | b; }
+            static uint8_t range(uint8_t x, char lo, char hi) { return x >= splat(lo) && x <= splat(hi); }
+            static uint64_t mask(uint8_t x) { return x; }
+        };
+
+        /*
+         * @return the first byte in [cursor, limit) where test is true, or where it's false if Negate is set
+         *
+         * V describes one instruction set: width bytes per load, a mask() holding bitsPerByte bits for every byte and
+         * full which is the mask when every byte matched. loads never go past limit which sits on the terminator
+         */
+        template <typename V, bool Negate, typename VectorTest, typename ByteTest>
+        inline const char * findFirst(const char * cursor, const char * limit, VectorTest vectorTest, ByteTest byteTest)
+        {
+            while (static_cast<size_t>(limit - cursor) >= V::width)
+            {
+                uint64_t mask = V::mask(vectorTest(V::load(cursor)));
+
+                if constexpr (Negate) mask ^= V::full;
+
+                if (mask != 0)
+                {
+                    return cursor + firstBit(mask) / V::bitsPerByte;
+                }
+
+                cursor += V::width;
+            }
+
+            // whatever is left is shorter than a full vector
+            while (cursor < limit && byteTest(*cursor) == Negate) ++cursor;
+
+            return cursor;
+        }
+
+        template <typename V>
+        struct Kernels
+        {
+            static const char * skipWhitespace(const char * cursor, const char * limit)
+            {
+                return findFirst<V, true>(cursor, limit, [](auto x) { return V::either(V::either(V::eq(x, ' '), V::eq(x, '\t')), V::either(V::eq(x, '\r'), V::eq(x, '\n'))); }, whitespaceByte);
+            }
+
+            static const char * findIdentifierEnd(const char * cursor, const char * limit)
+            {
+                return findFirst<V, true>(cursor, limit, [](auto x)
+                    {
+                        // folding in 0x20 turns upper case into lower case so one range covers both
+                        const auto letter = V::range(V::either(x, V::splat(0x20)), 'a', 'z');
+                        const auto digit = V::range(x, '0', '9');
+                        const auto symbol = V::either(V::either(V::eq(x, '_'), V::eq(x, '-')), V::either(V::eq(x, '*'), V::eq(x, '.')));
+
+                        return V::either(V::either(letter, digit), symbol);
+                    }, identifierByte);
+            }
+
+            static const char * findLineEnd(const char * cursor, const char * limit)
+            {
+                return findFirst<V, false>(cursor, limit, [](auto x) { return V::either(V::eq(x, '\r'), V::eq(x, '\n')); }, lineEndByte);
+            }
+
+            static const char * findExpressionEnd(const char * cursor, const char * limit)
+            {
+                return findFirst<V, false>(cursor, limit, [](auto x) { return V::either(V::either(V::eq(x, ';'), V::eq(x, '"')), V::either(V::eq(x, '['), V::eq(x, '/'))); }, expressionStopByte);
+            }
+
+            static const char * findStringEnd(const char * cursor, const char * limit)
+            {
+                return findFirst<V, false>(cursor, limit, [](auto x) { return V::either(V::eq(x, '"'), V::eq(x, '\\')); }, stringStopByte);
+            }
+
+            static const char * findEmbeddedEnd(const char * cursor, const char * limit)
+            {
+                return findFirst<V, false>(cursor, limit, [](auto x) { return V::either(V::eq(x, ']'), V::eq(x, '/')); }, embeddedStopByte);
+            }
+
+            static constexpr FuelPreScanKernels table(FuelPreScanner::Isa isa)
+            {
+                return { isa, skipWhitespace, findIdentifierEnd, findLineEnd, findExpressionEnd, findStringEnd, findEmbeddedEnd };
+            }
+        };
+    }
+}
@@ -0,0 +1,192 @@
+
+#include "FuelPreScanner.hpp"
+
+#include <atomic>
+#include <initializer_list>
+#include "FuelPreScanKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FUEL_PRESCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define FUEL_PRESCAN_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ehb
+{
+    namespace
+    {
+#if defined(FUEL_PRESCAN_SSE2)
+        struct Sse2Ops
+        {
+            static constexpr size_t width = 16;
+            static constexpr unsigned int bitsPerByte = 1;
+            static constexpr uint64_t full = 0xffff;
+
+            static __m128i load(const char * data) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)); }
+            static __m128i splat(char c) { return _mm_set1_epi8(c); }
+            static __m128i eq(__m128i x, char c) { return _mm_cmpeq_epi8(x, splat(c)); }
+            static __m128i either(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+
+            //! unsigned lo <= x <= hi, clamping x leaves it unchanged only when it's already inside the range
+            static __m128i range(__m128i x, char lo, char hi) { return _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(x, splat(lo)), splat(hi)), x); }
+
+            static uint64_t mask(__m128i x) { return static_cast<uint32_t>(_mm_movemask_epi8(x)); }
+        };
+#endif
+
+#if defined(FUEL_PRESCAN_NEON)
+        struct NeonOps
+        {
+            static constexpr size_t width = 16;
+            static constexpr unsigned int bitsPerByte = 4;
+            static constexpr uint64_t full = ~uint64_t(0);
+
+            static uint8x16_t load(const char * data) { return vld1q_u8(reinterpret_cast<const uint8_t *>(data)); }
+            static uint8x16_t splat(char c) { return vdupq_n_u8(static_cast<uint8_t>(c)); }
+            static uint8x16_t eq(uint8x16_t x, char c) { return vceqq_u8(x, splat(c)); }
+            static uint8x16_t either(uint8x16_t a, uint8x16_t b) { return vorrq_u8(a, b); }
+            static uint8x16_t range(uint8x16_t x, char lo, char hi) { return vandq_u8(vcgeq_u8(x, splat(lo)), vcleq_u8(x, splat(hi))); }
+
+            //! there is no movemask on arm, narrowing each 16 bit lane by 4 leaves a nibble for every byte instead
+            static uint64_t mask(uint8x16_t x) { return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(x), 4)), 0); }
+        };
+#endif
+
+        constexpr FuelPreScanKernels scalarKernels = Kernels<ScalarOps>::table(FuelPreScanner::Isa::Scalar);
+
+#if defined(FUEL_PRESCAN_SSE2)
+        constexpr FuelPreScanKernels sse2Kernels = Kernels<Sse2Ops>::table(FuelPreScanner::Isa::SSE2);
+#endif
+
+#if defined(FUEL_PRESCAN_NEON)
+        constexpr FuelPreScanKernels neonKernels = Kernels<NeonOps>::table(FuelPreScanner::Isa::NEON);
+#endif
+
+        bool cpuHasAvx2()
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            int info[4];
+
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+
+            // the os has to be saving the ymm registers as well as the cpu supporting the instructions
+            __cpuid(info, 1);
+            if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+
+        const FuelPreScanKernels * kernelsFor(FuelPreScanner::Isa isa)
+        {
+            switch (isa)
+            {
+                case FuelPreScanner::Isa::Scalar: return &scalarKernels;
+#if defined(FUEL_PRESCAN_SSE2)
+                case FuelPreScanner::Isa::SSE2: return &sse2Kernels;
+#endif
+#if defined(FUEL_PRESCAN_NEON)
+                case FuelPreScanner::Isa::NEON: return &neonKernels;
+#endif
+                case FuelPreScanner::Isa::AVX2: return cpuHasAvx2() ? avx2PreScanKernels() : nullptr;
+                default: return nullptr;
+            }
+        }
+
+        const FuelPreScanKernels * bestKernels()
+        {
+            for (FuelPreScanner::Isa isa : { FuelPreScanner::Isa::AVX2, FuelPreScanner::Isa::SSE2, FuelPreScanner::Isa::NEON })
+            {
+                if (const FuelPreScanKernels * kernels = kernelsFor(isa))
+                {
+                    return kernels;
+                }
+            }
+
+            return &scalarKernels;
+        }
+
+        //! a function static so a gas file loaded during static initialization still gets a kernel
+        std::atomic<const FuelPreScanKernels *> & active()
+        {
+            static std::atomic<const FuelPreScanKernels *> kernels(bestKernels());
+
+            return kernels;
+        }
+    }
+
+    const char * FuelPreScanner::skipWhitespace(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->skipWhitespace(cursor, limit);
+    }
+
+    const char * FuelPreScanner::findIdentifierEnd(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->findIdentifierEnd(cursor, limit);
+    }
+
+    const char * FuelPreScanner::findLineEnd(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->findLineEnd(cursor, limit);
+    }
+
+    const char * FuelPreScanner::findExpressionEnd(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->findExpressionEnd(cursor, limit);
+    }
+
+    const char * FuelPreScanner::findStringEnd(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->findStringEnd(cursor, limit);
+    }
+
+    const char * FuelPreScanner::findEmbeddedEnd(const char * cursor, const char * limit)
+    {
+        return active().load(std::memory_order_relaxed)->findEmbeddedEnd(cursor, limit);
+    }
+
+    FuelPreScanner::Isa FuelPreScanner::isa()
+    {
+        return active().load(std::memory_order_relaxed)->isa;
+    }
+
+    FuelPreScanner::Isa FuelPreScanner::best()
+    {
+        return bestKernels()->isa;
+    }
+
+    bool FuelPreScanner::select(Isa isa)
+    {
+        if (const FuelPreScanKernels * kernels = kernelsFor(isa))
+        {
+            active().store(kernels, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    const char * FuelPreScanner::name(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::Scalar: return "scalar";
+            case Isa::SSE2: return "SSE2";
+            case Isa::AVX2: return "AVX2";
+            case Isa::NEON: return "NEON";
+        }
+
+        return "unknown";
+    }
+}
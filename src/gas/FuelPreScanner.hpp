@@ -0,0 +1,74 @@
+
+#pragma once
+
+namespace ehb
+{
+    struct FuelPreScanKernels;
+
+    /*
+     * finds the end of the byte runs which make up most of a gas file so FuelScanner can step over them in one go
+     * instead of looping through its state machine a byte at a time
+     *
+     * every function takes the current position and the end of the document, which has to be null terminated, and returns
+     * the first byte that is not part of the run. the generated scanner is still what decides what that byte means
+     *
+     * the work is done 16 or 32 bytes at a time with SSE2, AVX2 or NEON depending on what the cpu supports, picked once at startup
+     */
+    class FuelPreScanner final
+    {
+    public:
+
+        enum class Isa
+        {
+            Scalar,
+            SSE2,
+            AVX2,
+            NEON
+        };
+
+        //! \t \n \r and space
+        static bool isWhitespace(char c);
+
+        //! everything that can be part of an identifier outside of an expression: [0-9a-zA-Z_-*.]
+        static bool isIdentifier(char c);
+
+        static const char * skipWhitespace(const char * cursor, const char * limit);
+        static const char * findIdentifierEnd(const char * cursor, const char * limit);
+
+        //! the end of a // comment, either \r or \n
+        static const char * findLineEnd(const char * cursor, const char * limit);
+
+        //! plain text inside an expression, stops at ; " [ and / which might change the state of the scanner
+        static const char * findExpressionEnd(const char * cursor, const char * limit);
+
+        //! plain text inside a string literal, stops at " and the start of an escape
+        static const char * findStringEnd(const char * cursor, const char * limit);
+
+        //! plain text inside a [[ ]] expression, stops at ] and /
+        static const char * findEmbeddedEnd(const char * cursor, const char * limit);
+
+        //! @return the instruction set currently in use
+        static Isa isa();
+
+        //! @return the best instruction set supported by this build and cpu
+        static Isa best();
+
+        /*
+         * switch to a different instruction set, this is only meant for benchmarks and tests comparing implementations
+         * @return false if isa isn't supported in which case nothing changes
+         */
+        static bool select(Isa isa);
+
+        static const char * name(Isa isa);
+    };
+
+    inline bool FuelPreScanner::isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline bool FuelPreScanner::isIdentifier(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '-' || c == '*' || c == '.';
+    }
+}
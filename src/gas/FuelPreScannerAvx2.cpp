@@ -0,0 +1,45 @@
+
+/*
+ * the AVX2 FuelPreScanner kernels, this file is compiled with AVX2 enabled and is only
+ * ever called after FuelPreScanner has checked that the cpu it's running on supports it
+ */
+
+#include "FuelPreScanKernels.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace ehb
+{
+#if defined(__AVX2__)
+    namespace
+    {
+        struct Avx2Ops
+        {
+            static constexpr size_t width = 32;
+            static constexpr unsigned int bitsPerByte = 1;
+            static constexpr uint64_t full = 0xffffffff;
+
+            static __m256i load(const char * data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data)); }
+            static __m256i splat(char c) { return _mm256_set1_epi8(c); }
+            static __m256i eq(__m256i x, char c) { return _mm256_cmpeq_epi8(x, splat(c)); }
+            static __m256i either(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+            static __m256i range(__m256i x, char lo, char hi) { return _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(x, splat(lo)), splat(hi)), x); }
+            static uint64_t mask(__m256i x) { return static_cast<uint32_t>(_mm256_movemask_epi8(x)); }
+        };
+
+        constexpr FuelPreScanKernels avx2Kernels = Kernels<Avx2Ops>::table(FuelPreScanner::Isa::AVX2);
+    }
+
+    const FuelPreScanKernels * avx2PreScanKernels()
+    {
+        return &avx2Kernels;
+    }
+#else
+    const FuelPreScanKernels * avx2PreScanKernels()
+    {
+        return nullptr;
+    }
+#endif
+}
@@ -21,6 +21,7 @@
 
 #include "FuelParser.hpp"
 #include "gas/FuelScanner.hpp"
+#include "gas/FuelPreScanner.hpp"
 
 namespace ehb
 {
@@ -38,6 +39,8 @@ namespace ehb
         {
             const char * start = cursor;
 
+            token = start;
+
             if (state.empty())
             {
                 /*
@@ -45,6 +48,28 @@ namespace ehb
                  * there is a typo here as the ';' should be a ','
                  */
 
+                // whitespace, comments and identifiers are most of a file so step over them without going through the state machine
+                if (preScan && FuelPreScanner::isWhitespace(*cursor))
+                {
+                    cursor = FuelPreScanner::skipWhitespace(cursor, limit);
+
+                    continue;
+                }
+
+                if (preScan && FuelPreScanner::isIdentifier(*cursor))
+                {
+                    cursor = FuelPreScanner::findIdentifierEnd(cursor, limit);
+
+                    return (*yylval = yytext, FuelParser::token::Identifier);
+                }
+
+                if (preScan && cursor[0] == '/' && cursor[1] == '/')
+                {
+                    cursor = FuelPreScanner::findLineEnd(cursor + 2, limit);
+
+                    continue;
+                }
+
                 
 {
 	unsigned char yych;
@@ -139,7 +164,7 @@ yy2:
 yy4:
 	++YYCURSOR;
 yy5:
-	{ std::cerr << "unexpected character found: '" << start[0] << "' (" << static_cast<int>(start[0]) << ")" << std::endl; return 0; }
+	{ report("unexpected character '" + std::string(1, start[0]) + "' (" + std::to_string(static_cast<unsigned char>(start[0])) + ")"); return 0; }
 yy6:
 	++YYCURSOR;
 	if (YYLIMIT <= YYCURSOR) YYFILL(1);
@@ -304,6 +329,14 @@ yy38:
             }
             else if (state.top() == embedded_statement)
             {
+                // hand the parser a whole run of plain text at once, expression_list joins them back together either way
+                if (const char * end = preScan ? FuelPreScanner::findEmbeddedEnd(cursor, limit) : cursor; end != cursor)
+                {
+                    cursor = end;
+
+                    return (*yylval = yytext, FuelParser::token::Expression);
+                }
+
                 
 {
 	unsigned char yych;
@@ -358,6 +391,14 @@ yy51:
             }
             else if (state.top() == expression_statement)
             {
+                // hand the parser a whole run of plain text at once, expression_list joins them back together either way
+                if (const char * end = preScan ? FuelPreScanner::findExpressionEnd(cursor, limit) : cursor; end != cursor)
+                {
+                    cursor = end;
+
+                    return (*yylval = yytext, FuelParser::token::Expression);
+                }
+
                 
 {
 	unsigned char yych;
@@ -420,6 +461,14 @@ yy68:
             }
             else if (state.top() == string_literal)
             {
+                // hand the parser a whole run of characters at once, expression_list joins them back together either way
+                if (const char * end = preScan ? FuelPreScanner::findStringEnd(cursor, limit) : cursor; end != cursor)
+                {
+                    cursor = end;
+
+                    return (*yylval = yytext, FuelParser::token::Expression);
+                }
+
                 
 {
 	unsigned char yych;
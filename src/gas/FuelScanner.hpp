@@ -20,9 +20,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <stack>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <cstring>
+#include "FuelDiagnostic.hpp"
 
 namespace ehb
 {
@@ -30,10 +34,23 @@ namespace ehb
     {
     public:
 
-        FuelScanner(const char * content);
+        /*
+         * @param diagnostics where problems are reported, nothing is reported if this is null
+         * @param preScan false to leave every byte to the generated state machine, this is only meant for checking the pre-scanner
+         */
+        FuelScanner(const char * content, std::vector<FuelDiagnostic> * diagnostics = nullptr, bool preScan = true);
 
         int scan(std::string * yylval);
 
+        //! record a problem at the start of the last token scanned
+        void report(const std::string & message);
+
+        //! mark the last problem reported as one the parser got past
+        void recovered();
+
+        //! @return the text of the last token scanned, empty at the end of the document
+        std::string_view lastToken() const;
+
     private:
 
         enum
@@ -51,10 +68,43 @@ namespace ehb
         const char * cursor;
         const char * limit;
         const char * marker;
+
+        //! start of the last token returned by scan
+        const char * token;
+
+        std::vector<FuelDiagnostic> * diagnostics;
+
+        bool preScan;
     };
 
-    inline FuelScanner::FuelScanner(const char * content) : content(content), cursor(content)
+    inline FuelScanner::FuelScanner(const char * content, std::vector<FuelDiagnostic> * diagnostics, bool preScan) : content(content), cursor(content), token(content), diagnostics(diagnostics), preScan(preScan)
     {
         limit = content + strlen(content);
     }
+
+    inline void FuelScanner::report(const std::string & message)
+    {
+        if (diagnostics != nullptr)
+        {
+            FuelDiagnostic diagnostic;
+            diagnostic.locate(std::string_view(content, limit - content), token - content);
+            diagnostic.message = message;
+
+            diagnostics->push_back(std::move(diagnostic));
+        }
+    }
+
+    inline void FuelScanner::recovered()
+    {
+        if (diagnostics != nullptr && !diagnostics->empty())
+        {
+            diagnostics->back().recovered = true;
+        }
+    }
+
+    inline std::string_view FuelScanner::lastToken() const
+    {
+        // the terminator gets consumed when the end of the document is scanned
+        return token < limit ? std::string_view(token, std::min(cursor, limit) - token) : std::string_view();
+    }
 }
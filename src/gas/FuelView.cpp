@@ -0,0 +1,287 @@
+
+#include "FuelView.hpp"
+
+#include <cstring>
+#include <istream>
+#include <iterator>
+
+namespace ehb
+{
+    //! split a comma separated value into exactly N numbers the same way FuelBlock does
+    template <typename T, size_t N, typename Convert>
+    static bool parseList(std::string_view value, std::array<T, N>& result, Convert convert)
+    {
+        for (size_t count = 0; count < N; ++count)
+        {
+            const size_t index = value.find(',');
+
+            // only the last item is allowed to run up to the end of the value
+            if ((index == std::string_view::npos) != (count == N - 1)) return false;
+
+            try
+            {
+                result[count] = convert(std::string(value.substr(0, index)));
+            }
+            catch (...)
+            {
+                return false;
+            }
+
+            value.remove_prefix(index != std::string_view::npos ? index + 1 : value.size());
+        }
+
+        return true;
+    }
+
+    FuelViewBlock FuelViewBlock::child(std::string_view name) const
+    {
+        FuelViewBlock block = *this;
+
+        while (!name.empty())
+        {
+            const size_t index = name.find(':');
+            const std::string_view childName = name.substr(0, index);
+
+            FuelViewBlock next;
+
+            for (FuelViewBlock node : block.eachChild())
+            {
+                if (node.name() == childName)
+                {
+                    next = node;
+
+                    break;
+                }
+            }
+
+            if (!next || index == std::string_view::npos) return next;
+
+            block = next;
+            name.remove_prefix(index + 1);
+        }
+
+        return FuelViewBlock();
+    }
+
+    const gasb::AttrRecord* FuelViewBlock::attribute(std::string_view name) const
+    {
+        FuelViewBlock parent = *this;
+
+        // same as FuelBlock, everything before the last ':' is the path to the block holding the attribute
+        if (const size_t index = name.rfind(':'); index != std::string_view::npos)
+        {
+            parent = child(name.substr(0, index));
+            name.remove_prefix(index + 1);
+        }
+
+        if (parent)
+        {
+            const gasb::BlockRecord& block = parent.record();
+
+            for (uint32_t a = block.firstAttr; a < block.firstAttr + block.attrCount; ++a)
+            {
+                if (mView->string(mView->mAttrs[a].name) == name)
+                {
+                    return mView->mAttrs + a;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool FuelViewBlock::valueAsBool(std::string_view name, bool defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            // anything spelling out true was decoded as a bool when the view was built
+            return attr->kind == gasb::ValueKind::Bool && attr->i != 0;
+        }
+
+        return defaultValue;
+    }
+
+    int FuelViewBlock::valueAsInt(std::string_view name, int defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (attr->kind == gasb::ValueKind::Int) return attr->i;
+
+            const int base = mView->string(attr->type) == "x" ? 16 : 10;
+
+            try
+            {
+                return std::stoi(std::string(mView->string(attr->value)), nullptr, base);
+            }
+            catch (...)
+            {
+            }
+        }
+
+        return defaultValue;
+    }
+
+    std::array<int, 4> FuelViewBlock::valueAsInt4(std::string_view name, const std::array<int, 4> defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            // decoded float lists can't be used here as stoi stops at the first character it doesn't like
+            if (std::array<int, 4> result; parseList(mView->string(attr->value), result, [](const std::string& item) { return std::stoi(item); }))
+            {
+                return result;
+            }
+        }
+
+        return defaultValue;
+    }
+
+    unsigned int FuelViewBlock::valueAsUInt(std::string_view name, unsigned int defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (attr->kind == gasb::ValueKind::Int) return static_cast<unsigned int>(attr->i);
+
+            const int base = mView->string(attr->type) == "x" ? 16 : 10;
+
+            try
+            {
+                return std::stoul(std::string(mView->string(attr->value)), nullptr, base);
+            }
+            catch (...)
+            {
+            }
+        }
+
+        return defaultValue;
+    }
+
+    float FuelViewBlock::valueAsFloat(std::string_view name, float defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (attr->kind == gasb::ValueKind::Float) return attr->f[0];
+
+            // hex values were decoded with base 16 which isn't how FuelBlock reads them as floats
+            if (attr->kind == gasb::ValueKind::Int && mView->string(attr->type) != "x") return static_cast<float>(attr->i);
+
+            try
+            {
+                return std::stof(std::string(mView->string(attr->value)), nullptr);
+            }
+            catch (...)
+            {
+            }
+        }
+
+        return defaultValue;
+    }
+
+    std::string FuelViewBlock::valueAsString(std::string_view name, const std::string& defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (const std::string_view value = mView->string(attr->value); value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            {
+                return std::string(value.substr(1, value.size() - 2));
+            }
+        }
+
+        return defaultValue;
+    }
+
+    template <size_t N>
+    bool FuelViewBlock::valueAsFloats(std::string_view name, std::array<float, N>& result) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (attr->kind == gasb::ValueKind::FloatList && attr->count == N)
+            {
+                std::memcpy(result.data(), attr->f, sizeof(float) * N);
+
+                return true;
+            }
+
+            return parseList(mView->string(attr->value), result, [](const std::string& item) { return std::stof(item); });
+        }
+
+        return false;
+    }
+
+    std::array<float, 3> FuelViewBlock::valueAsFloat3(std::string_view name, const std::array<float, 3> defaultValue) const
+    {
+        std::array<float, 3> result;
+
+        return valueAsFloats(name, result) ? result : defaultValue;
+    }
+
+    std::array<float, 4> FuelViewBlock::valueAsFloat4(std::string_view name, const std::array<float, 4> defaultValue) const
+    {
+        std::array<float, 4> result;
+
+        return valueAsFloats(name, result) ? result : defaultValue;
+    }
+
+    osg::Vec3 FuelViewBlock::valueAsVec3(std::string_view name, const osg::Vec3& defaultValue) const
+    {
+        if (std::array<float, 3> result; valueAsFloats(name, result))
+        {
+            return osg::Vec3(result[0], result[1], result[2]);
+        }
+
+        return defaultValue;
+    }
+
+    osg::Vec4 FuelViewBlock::valueAsColor(std::string_view name, const osg::Vec4& defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            if (const std::string_view value = mView->string(attr->value); value != "-1")
+            {
+                try
+                {
+                    const unsigned int color = std::stoul(std::string(value), nullptr, 16);
+
+                    const uint8_t r = (color >> 16) & 255;
+                    const uint8_t g = (color >> 8) & 255;
+                    const uint8_t b = color & 255;
+
+                    return osg::Vec4(r, g, b, 255.f) / 255.f;
+                }
+                catch (...)
+                {
+                }
+            }
+        }
+
+        return defaultValue;
+    }
+
+    bool FuelView::open(const char* data, size_t size, std::shared_ptr<const void> owner)
+    {
+        mOwner.reset();
+        mHeader = {};
+        mOffsets = nullptr;
+        mStrings = nullptr;
+        mBlocks = nullptr;
+        mAttrs = nullptr;
+
+        if (!FuelBinary::validate(data, size)) return false;
+
+        std::memcpy(&mHeader, data, sizeof(mHeader));
+
+        mOwner = std::move(owner);
+        mOffsets = reinterpret_cast<const uint32_t*>(data + sizeof(gasb::Header));
+        mStrings = reinterpret_cast<const char*>(mOffsets + mHeader.stringCount + 1);
+        mBlocks = reinterpret_cast<const gasb::BlockRecord*>(mStrings + ((mHeader.stringBytes + 3) & ~3u));
+        mAttrs = reinterpret_cast<const gasb::AttrRecord*>(mBlocks + mHeader.blockCount);
+
+        return true;
+    }
+
+    bool FuelView::load(std::istream& stream)
+    {
+        auto buffer = std::make_shared<std::string>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+        return open(buffer->data(), buffer->size(), buffer);
+    }
+}
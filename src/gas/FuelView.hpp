@@ -0,0 +1,464 @@
+
+#pragma once
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <osg/Vec3>
+#include <osg/Vec4>
+#include "FuelBinary.hpp"
+
+namespace ehb
+{
+    class FuelView;
+
+    //! an attribute inside a FuelView, only valid as long as the view it came from
+    class FuelViewAttribute final
+    {
+        friend class FuelView;
+        friend class FuelViewBlock;
+
+    public:
+
+        std::string_view name() const;
+        std::string_view type() const;
+        std::string_view value() const;
+
+    private:
+
+        FuelViewAttribute(const FuelView* view, const gasb::AttrRecord* record);
+
+    private:
+
+        const FuelView* mView;
+        const gasb::AttrRecord* mRecord;
+    };
+
+    /*
+     * a block inside a FuelView, this is just an index and is only valid as long as the view it came from
+     * navigation and lookups behave exactly like their FuelBlock counterparts, paths like "aspect:model" included
+     */
+    class FuelViewBlock final
+    {
+        friend class FuelView;
+
+    public:
+
+        //! walks either the children of a block or its attributes, both are contiguous in the view
+        template <typename T>
+        class Range;
+
+        FuelViewBlock() = default;
+
+        explicit operator bool() const;
+
+        //! @return the position of this block in its view, see FuelView::block
+        uint32_t index() const;
+
+        //! @return the parent block or an invalid block for the document
+        FuelViewBlock parent() const;
+
+        std::string_view name() const;
+        std::string_view type() const;
+
+        //! @return whether this block has no child blocks and attributes or not
+        bool isEmpty() const;
+
+        //! @return the child found by following name or an invalid block
+        FuelViewBlock child(std::string_view name) const;
+
+        Range<FuelViewBlock> eachChild() const;
+        Range<FuelViewBlock> eachChildOf(std::string_view name) const;
+
+        bool hasAttr(std::string_view name) const;
+
+        Range<FuelViewAttribute> eachAttribute() const;
+        Range<FuelViewAttribute> eachAttrOf(std::string_view name) const;
+
+        unsigned int valueCount() const;
+
+        std::string_view nameOf(unsigned int index) const;
+        std::string_view typeOf(unsigned int index) const;
+        std::string_view valueOf(unsigned int index) const;
+
+        std::string_view valueOf(std::string_view name, std::string_view defaultValue = {}) const;
+        std::string_view typeOf(std::string_view name, std::string_view defaultValue = {}) const;
+
+        /*
+         * same conversions as FuelBlock::valueAs*, values that were decoded when the document was
+         * converted to binary are returned without touching the text at all
+         */
+        bool valueAsBool(std::string_view name, bool defaultValue = false) const;
+        int valueAsInt(std::string_view name, int defaultValue = 0) const;
+        std::array<int, 4> valueAsInt4(std::string_view name, const std::array<int, 4> defaultValue = { 0, 0, 0, 0 }) const;
+        unsigned int valueAsUInt(std::string_view name, unsigned int defaultValue = 0) const;
+        float valueAsFloat(std::string_view name, float defaultValue = 0.f) const;
+        std::string valueAsString(std::string_view name, const std::string& defaultValue = "") const;
+
+        std::array<float, 3> valueAsFloat3(std::string_view name, const std::array<float, 3> defaultValue = { 1.0, 1.0, 1.0 }) const;
+        std::array<float, 4> valueAsFloat4(std::string_view name, const std::array<float, 4> defaultValue = { 1.0, 1.0, 1.0, 1.0 }) const;
+        osg::Vec3 valueAsVec3(std::string_view name, const osg::Vec3& defaultValue = { 1.0, 1.0, 1.0 }) const;
+        osg::Vec4 valueAsColor(std::string_view name, const osg::Vec4& defaultValue = { 1.f, 1.f, 1.f, 1.f }) const;
+
+    private:
+
+        FuelViewBlock(const FuelView* view, uint32_t index);
+
+        const gasb::BlockRecord& record() const;
+
+        const gasb::AttrRecord* attribute(std::string_view name) const;
+
+        template <size_t N>
+        bool valueAsFloats(std::string_view name, std::array<float, N>& result) const;
+
+    private:
+
+        const FuelView* mView = nullptr;
+        uint32_t mIndex = 0;
+    };
+
+    template <typename T>
+    class FuelViewBlock::Range final
+    {
+    public:
+
+        class Iterator final
+        {
+        public:
+
+            Iterator(const FuelView* view, uint32_t index);
+
+            T operator * () const;
+            Iterator& operator ++ ();
+
+            bool operator == (const Iterator& rhs) const;
+            bool operator != (const Iterator& rhs) const;
+
+        private:
+
+            const FuelView* mView;
+            uint32_t mIndex;
+        };
+
+        Range() = default;
+        Range(const FuelView* view, uint32_t begin, uint32_t end);
+
+        Iterator begin() const;
+        Iterator end() const;
+
+        bool empty() const;
+
+    private:
+
+        const FuelView* mView = nullptr;
+        uint32_t mBegin = 0, mEnd = 0;
+    };
+
+    /*
+     * a read-only fuel document stored as flat tables instead of a tree of FuelBlocks
+     *
+     * blocks are laid out depth first with the range of blocks below them and the range of their attributes
+     * so walking a document touches a handful of contiguous arrays. binary fuel (.gasb) buffers are read in place so
+     * there are no per block allocations at all. text has to go through Fuel and Fuel::saveBinary first, which costs more
+     * than just reading it with Fuel, so a view is only worth it for binary files or documents that get queried a lot
+     */
+    class FuelView final
+    {
+        friend class FuelViewAttribute;
+        friend class FuelViewBlock;
+        friend class FuelViewBlock::Range<FuelViewBlock>;
+        friend class FuelViewBlock::Range<FuelViewAttribute>;
+
+    public:
+
+        FuelView() = default;
+
+        // blocks point back at the view they came from so views stay where they were created
+        FuelView(const FuelView&) = delete;
+        FuelView& operator=(const FuelView&) = delete;
+
+        /*
+         * use a binary fuel buffer in place, the buffer is validated before anything is read from it
+         * @param owner kept alive for as long as the view is, pass nullptr if data outlives the view by other means
+         */
+        bool open(const char* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+
+        //! read a binary fuel document into a buffer owned by the view, text documents are refused
+        bool load(std::istream& stream);
+
+        //! @return the document block, invalid if nothing is open
+        FuelViewBlock root() const;
+
+        //! shortcuts for looking things up on the document block
+        FuelViewBlock child(std::string_view name) const;
+        FuelViewBlock::Range<FuelViewBlock> eachChild() const;
+        FuelViewBlock::Range<FuelViewBlock> eachChildOf(std::string_view name) const;
+
+        //! @return the block at index in depth first order, block 0 is the document itself
+        FuelViewBlock block(uint32_t index) const;
+
+        uint32_t blockCount() const;
+        uint32_t attrCount() const;
+
+    private:
+
+        std::string_view string(uint32_t index) const;
+
+    private:
+
+        std::shared_ptr<const void> mOwner;
+
+        gasb::Header mHeader = {};
+        const uint32_t* mOffsets = nullptr;
+        const char* mStrings = nullptr;
+        const gasb::BlockRecord* mBlocks = nullptr;
+        const gasb::AttrRecord* mAttrs = nullptr;
+    };
+
+    inline FuelViewAttribute::FuelViewAttribute(const FuelView* view, const gasb::AttrRecord* record) : mView(view), mRecord(record)
+    {
+    }
+
+    inline std::string_view FuelViewAttribute::name() const
+    {
+        return mView->string(mRecord->name);
+    }
+
+    inline std::string_view FuelViewAttribute::type() const
+    {
+        return mView->string(mRecord->type);
+    }
+
+    inline std::string_view FuelViewAttribute::value() const
+    {
+        return mView->string(mRecord->value);
+    }
+
+    inline FuelViewBlock::FuelViewBlock(const FuelView* view, uint32_t index) : mView(view), mIndex(index)
+    {
+    }
+
+    inline FuelViewBlock::operator bool() const
+    {
+        return mView != nullptr;
+    }
+
+    inline uint32_t FuelViewBlock::index() const
+    {
+        return mIndex;
+    }
+
+    inline const gasb::BlockRecord& FuelViewBlock::record() const
+    {
+        return mView->mBlocks[mIndex];
+    }
+
+    inline FuelViewBlock FuelViewBlock::parent() const
+    {
+        const uint32_t parent = record().parent;
+
+        return parent != gasb::none ? FuelViewBlock(mView, parent) : FuelViewBlock();
+    }
+
+    inline std::string_view FuelViewBlock::name() const
+    {
+        return mView->string(record().name);
+    }
+
+    inline std::string_view FuelViewBlock::type() const
+    {
+        return mView->string(record().type);
+    }
+
+    inline bool FuelViewBlock::isEmpty() const
+    {
+        return record().end == mIndex + 1 && record().attrCount == 0;
+    }
+
+    inline FuelViewBlock::Range<FuelViewBlock> FuelViewBlock::eachChild() const
+    {
+        return Range<FuelViewBlock>(mView, mIndex + 1, record().end);
+    }
+
+    inline FuelViewBlock::Range<FuelViewBlock> FuelViewBlock::eachChildOf(std::string_view name) const
+    {
+        if (FuelViewBlock node = child(name))
+        {
+            return node.eachChild();
+        }
+
+        return Range<FuelViewBlock>();
+    }
+
+    inline bool FuelViewBlock::hasAttr(std::string_view name) const
+    {
+        return attribute(name) != nullptr;
+    }
+
+    inline FuelViewBlock::Range<FuelViewAttribute> FuelViewBlock::eachAttribute() const
+    {
+        return Range<FuelViewAttribute>(mView, record().firstAttr, record().firstAttr + record().attrCount);
+    }
+
+    inline FuelViewBlock::Range<FuelViewAttribute> FuelViewBlock::eachAttrOf(std::string_view name) const
+    {
+        if (FuelViewBlock node = child(name))
+        {
+            return node.eachAttribute();
+        }
+
+        return Range<FuelViewAttribute>();
+    }
+
+    inline unsigned int FuelViewBlock::valueCount() const
+    {
+        return record().attrCount;
+    }
+
+    inline std::string_view FuelViewBlock::nameOf(unsigned int index) const
+    {
+        return index < record().attrCount ? mView->string(mView->mAttrs[record().firstAttr + index].name) : std::string_view();
+    }
+
+    inline std::string_view FuelViewBlock::typeOf(unsigned int index) const
+    {
+        return index < record().attrCount ? mView->string(mView->mAttrs[record().firstAttr + index].type) : std::string_view();
+    }
+
+    inline std::string_view FuelViewBlock::valueOf(unsigned int index) const
+    {
+        return index < record().attrCount ? mView->string(mView->mAttrs[record().firstAttr + index].value) : std::string_view();
+    }
+
+    inline std::string_view FuelViewBlock::valueOf(std::string_view name, std::string_view defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            return mView->string(attr->value);
+        }
+
+        return defaultValue;
+    }
+
+    inline std::string_view FuelViewBlock::typeOf(std::string_view name, std::string_view defaultValue) const
+    {
+        if (const gasb::AttrRecord* attr = attribute(name))
+        {
+            return mView->string(attr->type);
+        }
+
+        return defaultValue;
+    }
+
+    template <typename T>
+    inline FuelViewBlock::Range<T>::Iterator::Iterator(const FuelView* view, uint32_t index) : mView(view), mIndex(index)
+    {
+    }
+
+    template <>
+    inline FuelViewBlock FuelViewBlock::Range<FuelViewBlock>::Iterator::operator * () const
+    {
+        return FuelViewBlock(mView, mIndex);
+    }
+
+    template <>
+    inline FuelViewAttribute FuelViewBlock::Range<FuelViewAttribute>::Iterator::operator * () const
+    {
+        return FuelViewAttribute(mView, mView->mAttrs + mIndex);
+    }
+
+    template <>
+    inline FuelViewBlock::Range<FuelViewBlock>::Iterator& FuelViewBlock::Range<FuelViewBlock>::Iterator::operator ++ ()
+    {
+        // skip over every descendant of the current child
+        mIndex = mView->mBlocks[mIndex].end;
+
+        return *this;
+    }
+
+    template <>
+    inline FuelViewBlock::Range<FuelViewAttribute>::Iterator& FuelViewBlock::Range<FuelViewAttribute>::Iterator::operator ++ ()
+    {
+        ++mIndex;
+
+        return *this;
+    }
+
+    template <typename T>
+    inline bool FuelViewBlock::Range<T>::Iterator::operator == (const Iterator& rhs) const
+    {
+        return mIndex == rhs.mIndex;
+    }
+
+    template <typename T>
+    inline bool FuelViewBlock::Range<T>::Iterator::operator != (const Iterator& rhs) const
+    {
+        return mIndex != rhs.mIndex;
+    }
+
+    template <typename T>
+    inline FuelViewBlock::Range<T>::Range(const FuelView* view, uint32_t begin, uint32_t end) : mView(view), mBegin(begin), mEnd(end)
+    {
+    }
+
+    template <typename T>
+    inline typename FuelViewBlock::Range<T>::Iterator FuelViewBlock::Range<T>::begin() const
+    {
+        return Iterator(mView, mBegin);
+    }
+
+    template <typename T>
+    inline typename FuelViewBlock::Range<T>::Iterator FuelViewBlock::Range<T>::end() const
+    {
+        return Iterator(mView, mEnd);
+    }
+
+    template <typename T>
+    inline bool FuelViewBlock::Range<T>::empty() const
+    {
+        return mBegin == mEnd;
+    }
+
+    inline FuelViewBlock FuelView::root() const
+    {
+        return mBlocks != nullptr ? FuelViewBlock(this, 0) : FuelViewBlock();
+    }
+
+    inline FuelViewBlock FuelView::child(std::string_view name) const
+    {
+        return mBlocks != nullptr ? root().child(name) : FuelViewBlock();
+    }
+
+    inline FuelViewBlock::Range<FuelViewBlock> FuelView::eachChild() const
+    {
+        return mBlocks != nullptr ? root().eachChild() : FuelViewBlock::Range<FuelViewBlock>();
+    }
+
+    inline FuelViewBlock::Range<FuelViewBlock> FuelView::eachChildOf(std::string_view name) const
+    {
+        return mBlocks != nullptr ? root().eachChildOf(name) : FuelViewBlock::Range<FuelViewBlock>();
+    }
+
+    inline FuelViewBlock FuelView::block(uint32_t index) const
+    {
+        return index < mHeader.blockCount ? FuelViewBlock(this, index) : FuelViewBlock();
+    }
+
+    inline uint32_t FuelView::blockCount() const
+    {
+        return mHeader.blockCount;
+    }
+
+    inline uint32_t FuelView::attrCount() const
+    {
+        return mHeader.attrCount;
+    }
+
+    inline std::string_view FuelView::string(uint32_t index) const
+    {
+        return std::string_view(mStrings + mOffsets[index], mOffsets[index + 1] - mOffsets[index] - 1);
+    }
+}
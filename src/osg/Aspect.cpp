@@ -1,6 +1,7 @@
 
 #include "Aspect.hpp"
 #include "AspectImpl.hpp"
+#include "TextureCache.hpp"
 
 #include <algorithm>
 #include <functional>
@@ -130,19 +131,15 @@ namespace ehb
                 // textures are stored directly against the mesh
                 // TODO: should we store the osg::Image against AspectImpl?
                 const std::string imageFilename = d->textureNames[i] + ".raw";
-                osg::ref_ptr<osg::Image> image = osgDB::readImageFile(imageFilename);
+                osg::ref_ptr<osg::Texture2D> texture = TextureCache::instance().texture(imageFilename, TextureCache::Wrap::Repeat);
 
                 geometry->setName(d->textureNames[i]);
 
-                if (image != nullptr)
+                if (texture != nullptr)
                 {
-                    osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
                     geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture);
                     geometry->getOrCreateStateSet()->setMode(GL_BLEND, osg::StateAttribute::ON);
 
-                    texture->setWrap(osg::Texture2D::WRAP_S, osg::Texture2D::REPEAT);
-                    texture->setWrap(osg::Texture2D::WRAP_T, osg::Texture2D::REPEAT);
-
                     log->debug("loaded image {} for asp sub mesh: {}", i, imageFilename);
                 }
 
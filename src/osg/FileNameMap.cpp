@@ -2,115 +2,264 @@
 #include "FileNameMap.hpp"
 
 #include <algorithm>
-#include <sstream>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include <osg/Timer>
 #include <osgDB/FileNameUtils>
 #include "IFileSys.hpp"
 
 namespace ehb
 {
-    // TODO: no really, make a real nnk parser
-    static std::string trim(const std::string & str)
+    /*
+     * a fixed size open addressed table of pointers which are only ever swapped from null to a finished entry, so readers
+     * never wait on a writer. entries live until the cache is destroyed and once it's mostly full new names are simply
+     * resolved every time instead of being stored
+     */
+    class FileNameMap::ResolveCache final
     {
-        if (!str.size()) return str;
-        std::string::size_type first = str.find_first_not_of( " \t" );
-        std::string::size_type last = str.find_last_not_of( "  \t\r\n" );
-        if ((first==str.npos) || (last==str.npos)) return std::string( "" );
-        return str.substr( first, last-first+1 );
-    }
+    public:
 
-    void FileNameMap::parseTree(std::unordered_map<std::string, std::string> & namingKeyMap, std::istream & stream)
-    {
-        for (std::string line; std::getline(stream, line);)
+        ResolveCache() : slots(capacity)
         {
-            line = trim(line);
+        }
 
-            if (line.empty())
+        ~ResolveCache()
+        {
+            for (auto & slot : slots)
             {
-                continue;
+                delete slot.load(std::memory_order_relaxed);
             }
+        }
 
-            if (line.front() != '#')
+        const std::string * find(const std::string & key, size_t hash) const
+        {
+            for (size_t i = 0, slot = hash & (capacity - 1); i < maxProbe; ++i, slot = (slot + 1) & (capacity - 1))
             {
-                std::stringstream lineStream(line);
+                const Entry * entry = slots[slot].load(std::memory_order_acquire);
 
-                std::string type, key, value, description, extra;
+                if (entry == nullptr)
+                {
+                    return nullptr;
+                }
+
+                if (entry->hash == hash && entry->key == key)
+                {
+                    return &entry->value;
+                }
+            }
+
+            return nullptr;
+        }
+
+        //! only the first of several threads inserting the same name keeps its entry
+        void insert(const std::string & key, size_t hash, const std::string & value)
+        {
+            if (count.load(std::memory_order_relaxed) >= capacity / 4 * 3) return;
 
-                std::getline(lineStream, type, '=');
-                std::getline(lineStream, key, ',');
-                std::getline(lineStream, value, ',');
-                std::getline(lineStream, description, ',');
-                std::getline(lineStream, extra);
+            Entry * created = new Entry{ hash, key, value };
 
-                type = trim(type);
-                key = trim(key);
-                value = trim(value);
-                extra = trim(extra);
+            for (size_t i = 0, slot = hash & (capacity - 1); i < maxProbe; ++i, slot = (slot + 1) & (capacity - 1))
+            {
+                const Entry * expected = nullptr;
 
-                if (type == "TREE")
+                if (slots[slot].compare_exchange_strong(expected, created, std::memory_order_acq_rel))
                 {
-                    std::replace(value.begin(), value.end(), '\\', '/');
+                    count.fetch_add(1, std::memory_order_relaxed);
 
-                    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-                    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-                    std::transform(extra.begin(), extra.end(), extra.begin(), ::tolower);
+                    return;
+                }
 
-                    auto index = key.find_last_of('_');
+                // another thread got here first with the same name
+                if (expected->hash == hash && expected->key == key)
+                {
+                    break;
+                }
+            }
 
-                    std::string fullFileName;
+            delete created;
+        }
 
-                    if (index != std::string::npos)
-                    {
-                        auto itr = namingKeyMap.find(key.substr(0, index));
+    private:
 
-                        if (itr != namingKeyMap.end()) {
+        struct Entry
+        {
+            size_t hash;
+            std::string key;
+            std::string value;
+        };
+
+        static constexpr size_t capacity = 1 << 15;
+        static constexpr size_t maxProbe = 16;
 
-                            fullFileName += itr->second;
-                            fullFileName += value;
-                            fullFileName += '/';
+        std::vector<std::atomic<const Entry *>> slots;
+        std::atomic<size_t> count = 0;
+    };
 
-                            namingKeyMap.emplace(key, fullFileName);
+    struct FileNameMap::Table
+    {
+        NamingKeyTrie trie;
 
-                            log->debug("storing '{}' as '{}'", key, fullFileName);
+        // filling in the memo doesn't change what any name resolves to
+        mutable ResolveCache cache;
 
-                            // take care of fighting stances
-                            if (!extra.empty())
-                            {
-                                std::stringstream extraStream(extra);
-                                std::string stance;
+        std::string resolve(const std::string & filename) const;
+    };
 
-                                while (std::getline(extraStream, stance, ','))
-                                {
-                                    stance = trim(stance);
+    namespace
+    {
+        //! leading spaces and tabs, trailing spaces, tabs and line endings
+        std::string_view trim(std::string_view str)
+        {
+            const size_t first = str.find_first_not_of(" \t");
+            const size_t last = str.find_last_not_of(" \t\r\n");
 
-                                    namingKeyMap.emplace(key + '_' + stance, fullFileName + stance + '/');
+            if (first == std::string_view::npos || last == std::string_view::npos) return {};
 
-                                    log->debug("storing '{}_{}' as '{}{}/'", key, stance, fullFileName, stance);
-                                }
-                            }
+            return str.substr(first, last - first + 1);
+        }
 
-                            continue;
-                        }
-                    }
+        //! everything up to the first delimiter, rest is left holding what comes after it
+        std::string_view field(std::string_view & rest, char delimiter)
+        {
+            const size_t end = rest.find(delimiter);
+            const std::string_view result = rest.substr(0, end);
+
+            rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+
+            return result;
+        }
+
+        void assignLower(std::string & out, std::string_view in)
+        {
+            out.assign(in);
+
+            for (char & c : out)
+            {
+                if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            }
+        }
+
+        //! fnv-1a, only used to tell if the naming key files have changed since the cache was written
+        uint64_t fingerprint(uint64_t hash, std::string_view data)
+        {
+            for (char c : data)
+            {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+    }
+
+    /*
+     * every line that matters looks like
+     *
+     *   TREE = KEY, directory, description, stance, stance...
+     *
+     * a key whose prefix up to its last '_' is already known goes in that directory, otherwise the directory is taken as is
+     */
+    void FileNameMap::parseTree(std::unordered_map<std::string, std::string> & namingKeyMap, std::string_view buffer)
+    {
+        const bool debug = log->should_log(spdlog::level::debug);
+
+        std::string key, value, parent, stance;
+
+        for (size_t start = 0; start < buffer.size();)
+        {
+            size_t end = buffer.find('\n', start);
+
+            if (end == std::string_view::npos) end = buffer.size();
+
+            const std::string_view line = trim(buffer.substr(start, end - start));
+
+            start = end + 1;
+
+            if (line.empty() || line.front() == '#')
+            {
+                continue;
+            }
+
+            std::string_view rest = line;
+
+            if (trim(field(rest, '=')) != "TREE")
+            {
+                continue;
+            }
+
+            assignLower(key, trim(field(rest, ',')));
+            assignLower(value, trim(field(rest, ',')));
 
+            std::replace(value.begin(), value.end(), '\\', '/');
+
+            // the description is only there for people reading the file
+            field(rest, ',');
+
+            std::string_view extra = trim(rest);
+
+            std::string fullFileName;
+
+            if (const size_t index = key.find_last_of('_'); index != std::string::npos)
+            {
+                parent.assign(key, 0, index);
+
+                if (auto itr = namingKeyMap.find(parent); itr != namingKeyMap.end())
+                {
+                    fullFileName.reserve(itr->second.size() + value.size() + 1);
+                    fullFileName += itr->second;
                     fullFileName += value;
+                    fullFileName += '/';
 
-                    if (!fullFileName.empty())
+                    if (debug) log->debug("storing '{}' as '{}'", key, fullFileName);
+
+                    // take care of fighting stances
+                    while (!extra.empty())
                     {
-                        fullFileName += '/';
+                        assignLower(stance, trim(field(extra, ',')));
+
+                        if (debug) log->debug("storing '{}_{}' as '{}{}/'", key, stance, fullFileName, stance);
+
+                        namingKeyMap.emplace(key + '_' + stance, fullFileName + stance + '/');
                     }
 
-                    namingKeyMap.emplace(key, fullFileName);
+                    namingKeyMap.emplace(key, std::move(fullFileName));
 
-                    log->debug("storing '{}' as '{}'", key, fullFileName);
+                    continue;
                 }
             }
+
+            fullFileName = value;
+
+            if (!fullFileName.empty())
+            {
+                fullFileName += '/';
+            }
+
+            if (debug) log->debug("storing '{}' as '{}'", key, fullFileName);
+
+            namingKeyMap.emplace(key, std::move(fullFileName));
         }
     }
 
-    FileNameMap::FileNameMap(IFileSys & fileSys)
+    FileNameMap::FileNameMap(IFileSys & fileSys, const std::string & cacheDirectory)
     {
         log = spdlog::get("filesystem");
 
+        if (!cacheDirectory.empty())
+        {
+            cacheFileName = osgDB::concatPaths(cacheDirectory, "namingkey.cache");
+        }
+
+        reload(fileSys);
+    }
+
+    FileNameMap::~FileNameMap() = default;
+
+    void FileNameMap::reload(IFileSys & fileSys)
+    {
         std::set<std::string> std, ext;
 
         for (const auto & filename : fileSys.getDirectoryContents("/art"))
@@ -148,51 +297,106 @@ namespace ehb
             eachFileName.push_back(*itr);
         }
 
+        osg::Timer timer;
+
+        std::vector<std::string> buffers;
+        uint64_t source = 14695981039346656037ull;
+
         for (const std::string & filename : eachFileName)
         {
-            std::stringstream stream;
-
             if (auto stream = fileSys.createInputStream(filename))
             {
-                // process it...
-                parseTree(keyMap, *stream);
+                auto & buffer = buffers.emplace_back(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+
+                // the name is part of the fingerprint as well so renaming or reordering the files invalidates the cache too
+                source = fingerprint(fingerprint(source, filename), buffer);
             }
         }
-    }
 
-    std::string ehb::FileNameMap::findDataFile(const std::string & filename, const osgDB::Options * options, osgDB::CaseSensitivity caseSensitivity)
-    {
-        std::string actualFileName = filename;
+        auto table = std::make_shared<Table>();
+
+        bool cached = false;
+
+        if (!cacheFileName.empty())
+        {
+            if (std::ifstream stream(cacheFileName, std::ios_base::binary); stream.is_open())
+            {
+                cached = table->trie.read(stream, source);
+            }
+        }
 
-        if (filename.find_first_of('/') == std::string::npos)
+        if (!cached)
         {
-            std::string resolvedFileName;
+            std::unordered_map<std::string, std::string> keyMap;
 
-            for (std::string::size_type index = filename.rfind('_'); index != std::string::npos && index != 0; index = filename.rfind('_', index - 1))
+            for (const std::string & buffer : buffers)
             {
-                auto itr = keyMap.find(filename.substr(0, index));
+                parseTree(keyMap, buffer);
+            }
 
-                if (itr != keyMap.end())
-                {
-                    resolvedFileName = itr->second + filename;
-                    break;
-                }
+            table->trie = NamingKeyTrie(keyMap);
+        }
+
+        log->info("naming key table holds {} keys, {} in {:.3f}ms", table->trie.size(), cached ? "read from cache" : "parsed", timer.time_m());
+
+        // the parsing above can happen on several threads at once, only publishing the result has to be serialized
+        std::lock_guard<std::mutex> lock(reloadMutex);
+
+        std::atomic_store(&current, std::shared_ptr<const Table>(table));
+
+        if (!cached && !cacheFileName.empty())
+        {
+            if (std::ofstream stream(cacheFileName, std::ios_base::binary); !stream.is_open() || !table->trie.write(stream, source))
+            {
+                log->warn("could not write the naming key cache to {}", cacheFileName);
             }
+        }
+    }
+
+    std::string FileNameMap::findDataFile(const std::string & filename, const osgDB::Options * options, osgDB::CaseSensitivity caseSensitivity)
+    {
+        // full paths are passed straight through so there's no point in filling the cache up with them
+        if (filename.find_first_of('/') != std::string::npos)
+        {
+            return filename;
+        }
+
+        // everything read through this pointer is finished before it's published, holding on to it keeps a reload from freeing it underneath us
+        const std::shared_ptr<const Table> table = std::atomic_load(&current);
+
+        const size_t hash = std::hash<std::string>()(filename);
 
-            if (!resolvedFileName.empty())
+        if (const std::string * cached = table->cache.find(filename, hash))
+        {
+            return *cached;
+        }
+
+        std::string actualFileName = table->resolve(filename);
+
+        table->cache.insert(filename, hash, actualFileName);
+
+        return actualFileName;
+    }
+
+    std::string FileNameMap::Table::resolve(const std::string & filename) const
+    {
+        const std::string_view prefix = std::string_view(filename).substr(0, 2);
+
+        if (prefix == "a_" || prefix == "b_" || prefix == "m_" || prefix == "t_")
+        {
+            if (const auto directory = trie.resolve(filename))
             {
-                const std::string prefix = filename.substr(0, 2);
+                std::string actualFileName;
 
-                if (prefix == "a_" || prefix == "b_" || prefix == "m_" || prefix == "t_")
-                {
-                    actualFileName.clear();
+                actualFileName.reserve(5 + directory->size() + filename.size());
+                actualFileName += "/art/";
+                actualFileName += *directory;
+                actualFileName += filename;
 
-                    actualFileName += "/art/";
-                    actualFileName += resolvedFileName;
-                }
+                return actualFileName;
             }
         }
 
-        return actualFileName;
+        return filename;
     }
 }
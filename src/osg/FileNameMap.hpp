@@ -1,10 +1,14 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <spdlog/spdlog.h>
 #include <osgDB/Callbacks>
+#include "NamingKeyTrie.hpp"
 
 // NOTE: this class violates several of my design decisions, but the code was already written and we can come back around to clean it up later
 namespace ehb
@@ -14,17 +18,36 @@ namespace ehb
     {
     public:
 
-        FileNameMap(IFileSys & fileSys);
+        //! the parsed naming key table is kept in cacheDirectory so later runs can skip parsing it, an empty directory turns that off
+        FileNameMap(IFileSys & fileSys, const std::string & cacheDirectory = "");
 
-        virtual ~FileNameMap() = default;
+        virtual ~FileNameMap();
 
+        //! safe to call from any number of threads at once, including while another thread is reloading
         std::string findDataFile(const std::string & filename, const osgDB::Options * options, osgDB::CaseSensitivity caseSensitivity) override;
 
+        /*
+         * parse the naming key files again and swap the new table in with a single atomic store, lookups already in flight
+         * finish against the table they started with and whichever of them finishes last frees it
+         */
+        void reload(IFileSys & fileSys);
+
     private:
 
-        void parseTree(std::unordered_map<std::string, std::string>& namingKeyMap, std::istream& stream);
+        void parseTree(std::unordered_map<std::string, std::string>& namingKeyMap, std::string_view buffer);
+
+        //! lock free memo of every name findDataFile has been asked about, osg asks for the same textures over and over
+        class ResolveCache;
+
+        //! a naming key trie and the memo of names resolved through it, never modified once it's been published
+        struct Table;
+
+        //! only ever read and written through std::atomic_load and std::atomic_store
+        std::shared_ptr<const Table> current;
+
+        std::mutex reloadMutex;
 
-        std::unordered_map<std::string, std::string> keyMap;
+        std::string cacheFileName;
 
         std::shared_ptr<spdlog::logger> log;
     };
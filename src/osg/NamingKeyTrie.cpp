@@ -0,0 +1,258 @@
+
+#include "NamingKeyTrie.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace ehb
+{
+    namespace
+    {
+        constexpr char magic[4] = { 'N', 'N', 'K', 'T' };
+        constexpr uint32_t version = 1;
+
+        struct Header
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t source;
+            uint32_t poolBytes;
+            uint32_t nodeCount;
+            uint32_t edgeCount;
+            uint32_t keyCount;
+        };
+
+        template <typename T>
+        bool readTable(std::istream & stream, std::vector<T> & table, size_t count)
+        {
+            table.resize(count);
+
+            return static_cast<bool>(stream.read(reinterpret_cast<char *>(table.data()), sizeof(T) * count));
+        }
+    }
+
+    NamingKeyTrie::NamingKeyTrie(const std::unordered_map<std::string, std::string> & keyMap)
+    {
+        // every segment of every key is an upper bound on the number of edges, keeping the table at most half full
+        size_t segmentCount = 0;
+
+        for (const auto & entry : keyMap)
+        {
+            segmentCount += std::count(entry.first.begin(), entry.first.end(), '_') + 1;
+        }
+
+        size_t capacity = 16;
+
+        while (capacity < segmentCount * 2) capacity *= 2;
+
+        edges.resize(capacity);
+        mask = static_cast<uint32_t>(capacity - 1);
+
+        nodes.emplace_back();
+
+        for (const auto & [key, value] : keyMap)
+        {
+            const std::string_view view(key);
+
+            uint32_t node = 0;
+
+            for (size_t start = 0;;)
+            {
+                const size_t end = view.find('_', start);
+                const std::string_view part = view.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+
+                node = insertChild(node, part);
+
+                if (end == std::string_view::npos) break;
+
+                start = end + 1;
+            }
+
+            Node & leaf = nodes[node];
+
+            leaf.valueOffset = static_cast<uint32_t>(pool.size());
+            leaf.valueLength = static_cast<uint32_t>(value.size());
+
+            pool += value;
+
+            keyCount++;
+        }
+
+        // keys share most of their prefixes so far fewer edges were needed than the estimate allowed for
+        size_t used = 16;
+
+        while (used < (nodes.size() - 1) * 2) used *= 2;
+
+        if (used < edges.size())
+        {
+            std::vector<Edge> previous(used);
+
+            previous.swap(edges);
+            mask = static_cast<uint32_t>(used - 1);
+
+            for (const Edge & edge : previous)
+            {
+                if (edge.child == 0) continue;
+
+                uint32_t slot = edge.hash & mask;
+
+                while (edges[slot].child != 0) slot = (slot + 1) & mask;
+
+                edges[slot] = edge;
+            }
+        }
+    }
+
+    std::optional<std::string_view> NamingKeyTrie::resolve(std::string_view name) const
+    {
+        if (nodes.empty()) return std::nullopt;
+
+        const Node * found = nullptr;
+
+        uint32_t node = 0;
+
+        // only segments followed by a '_' can end a candidate prefix, so the last segment is never looked at
+        for (size_t start = 0, end; (end = name.find('_', start)) != std::string_view::npos; start = end + 1)
+        {
+            const std::string_view part = name.substr(start, end - start);
+
+            node = findChild(node, part, hash(node, part));
+
+            if (node == 0) break;
+
+            if (nodes[node].valueOffset != noValue && end != 0)
+            {
+                found = &nodes[node];
+            }
+        }
+
+        if (found == nullptr) return std::nullopt;
+
+        return std::string_view(pool.data() + found->valueOffset, found->valueLength);
+    }
+
+    bool NamingKeyTrie::write(std::ostream & stream, uint64_t source) const
+    {
+        Header header = {};
+
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.source = source;
+        header.poolBytes = static_cast<uint32_t>(pool.size());
+        header.nodeCount = static_cast<uint32_t>(nodes.size());
+        header.edgeCount = static_cast<uint32_t>(edges.size());
+        header.keyCount = static_cast<uint32_t>(keyCount);
+
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(pool.data(), pool.size());
+        stream.write(reinterpret_cast<const char *>(nodes.data()), sizeof(Node) * nodes.size());
+        stream.write(reinterpret_cast<const char *>(edges.data()), sizeof(Edge) * edges.size());
+
+        return static_cast<bool>(stream);
+    }
+
+    bool NamingKeyTrie::read(std::istream & stream, uint64_t source)
+    {
+        Header header;
+
+        if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.source != source) return false;
+
+        // the edge table is probed with a mask so it has to be a power of two
+        if (header.nodeCount == 0 || header.edgeCount == 0 || (header.edgeCount & (header.edgeCount - 1)) != 0) return false;
+
+        NamingKeyTrie result;
+
+        result.pool.resize(header.poolBytes);
+
+        if (!stream.read(result.pool.data(), header.poolBytes)) return false;
+        if (!readTable(stream, result.nodes, header.nodeCount) || !readTable(stream, result.edges, header.edgeCount)) return false;
+
+        // a truncated or damaged file must not be able to send resolve outside of the tables
+        for (const Node & node : result.nodes)
+        {
+            if (node.valueOffset != noValue && static_cast<uint64_t>(node.valueOffset) + node.valueLength > header.poolBytes) return false;
+        }
+
+        size_t used = 0;
+
+        for (const Edge & edge : result.edges)
+        {
+            if (edge.child >= header.nodeCount || static_cast<uint64_t>(edge.segmentOffset) + edge.segmentLength > header.poolBytes) return false;
+
+            if (edge.child != 0) used++;
+        }
+
+        // findChild only stops at an empty slot so a table without one would spin forever on a missing segment
+        if (used >= header.edgeCount) return false;
+
+        result.mask = header.edgeCount - 1;
+        result.keyCount = header.keyCount;
+
+        *this = std::move(result);
+
+        return true;
+    }
+
+    uint32_t NamingKeyTrie::hash(uint32_t parent, std::string_view part)
+    {
+        // fnv-1a seeded with the parent so the same segment under different nodes lands in different slots
+        uint32_t result = 2166136261u ^ (parent * 16777619u);
+
+        for (char c : part)
+        {
+            result ^= static_cast<uint8_t>(c);
+            result *= 16777619u;
+        }
+
+        return result;
+    }
+
+    uint32_t NamingKeyTrie::findChild(uint32_t parent, std::string_view part, uint32_t hash) const
+    {
+        for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask)
+        {
+            const Edge & edge = edges[slot];
+
+            if (edge.child == 0)
+            {
+                return 0;
+            }
+
+            if (edge.hash == hash && edge.parent == parent && segment(edge) == part)
+            {
+                return edge.child;
+            }
+        }
+    }
+
+    uint32_t NamingKeyTrie::insertChild(uint32_t parent, std::string_view part)
+    {
+        const uint32_t h = hash(parent, part);
+
+        if (uint32_t child = findChild(parent, part, h))
+        {
+            return child;
+        }
+
+        uint32_t slot = h & mask;
+
+        while (edges[slot].child != 0) slot = (slot + 1) & mask;
+
+        Edge & edge = edges[slot];
+
+        edge.parent = parent;
+        edge.child = static_cast<uint32_t>(nodes.size());
+        edge.segmentOffset = static_cast<uint32_t>(pool.size());
+        edge.segmentLength = static_cast<uint32_t>(part.size());
+        edge.hash = h;
+
+        pool.append(part.data(), part.size());
+        nodes.emplace_back();
+
+        return edge.child;
+    }
+}
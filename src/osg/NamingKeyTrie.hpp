@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ehb
+{
+    /*
+     * the naming key table stored as a trie over the '_' separated segments of each key
+     *
+     * m_c_gah_fg is the path m -> c -> gah -> fg, every node that ends a key holds the directory for it. every segment
+     * string lives in one pool and the edges sit in a single open addressed table keyed by parent node and segment so
+     * resolving a name is one forward walk through it with no allocations
+     */
+    class NamingKeyTrie final
+    {
+    public:
+
+        NamingKeyTrie() = default;
+
+        //! build from the key -> directory map the nnk files are parsed into
+        explicit NamingKeyTrie(const std::unordered_map<std::string, std::string> & keyMap);
+
+        /*
+         * @return the directory for the longest key that is followed by a '_' in name, a key can map to an empty directory
+         *
+         * this gives the same answer as trying every prefix ending at a '_' from the right with a map lookup. a prefix of
+         * zero length never matches and keys are compared exactly, the nnk keys are all lower case
+         */
+        std::optional<std::string_view> resolve(std::string_view name) const;
+
+        size_t size() const;
+
+        /*
+         * the trie is written out as it sits in memory so reading it back is a handful of bulk reads with nothing to rebuild
+         *
+         * source identifies what it was built from, read fails if it doesn't match so a stale file is never used
+         */
+        bool write(std::ostream & stream, uint64_t source) const;
+        bool read(std::istream & stream, uint64_t source);
+
+    private:
+
+        static constexpr uint32_t noValue = 0xffffffff;
+
+        struct Node
+        {
+            uint32_t valueOffset = noValue; //!< noValue unless a key ends here
+            uint32_t valueLength = 0;
+        };
+
+        //! child == 0 marks an empty slot, the root is node 0 so it can never be a child
+        struct Edge
+        {
+            uint32_t parent = 0;
+            uint32_t child = 0;
+            uint32_t segmentOffset = 0;
+            uint32_t segmentLength = 0;
+            uint32_t hash = 0;
+        };
+
+        static uint32_t hash(uint32_t parent, std::string_view part);
+
+        uint32_t findChild(uint32_t parent, std::string_view part, uint32_t hash) const;
+        uint32_t insertChild(uint32_t parent, std::string_view part);
+
+        std::string_view segment(const Edge & edge) const;
+
+        std::string pool;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+        uint32_t mask = 0;
+        size_t keyCount = 0;
+    };
+
+    inline size_t NamingKeyTrie::size() const
+    {
+        return keyCount;
+    }
+
+    inline std::string_view NamingKeyTrie::segment(const Edge & edge) const
+    {
+        return std::string_view(pool.data() + edge.segmentOffset, edge.segmentLength);
+    }
+}
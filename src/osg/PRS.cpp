@@ -5,7 +5,35 @@
 
 namespace ehb
 {
-    PRS::PRS(ByteArray fileContents, std::string filename)
+    //! keys are stored back to back as floats, a time followed by either a quaternion or a position
+    static void readKeys(BinaryReader& reader, PRS::AnimSeq& seq, uint32_t rotKeyCount, uint32_t posKeyCount)
+    {
+        std::vector<float> scratch;
+
+        const Span<float> rotKeys = reader.readSpan(static_cast<size_t>(rotKeyCount) * 5, scratch);
+
+        seq.rotKeys.resize(rotKeyCount);
+        for (size_t i = 0; i < rotKeys.size() / 5; ++i)
+        {
+            const float* key = rotKeys.data() + i * 5;
+
+            seq.rotKeys[i].time = key[0];
+            seq.rotKeys[i].rotation.set(key[1], key[2], key[3], key[4]);
+        }
+
+        const Span<float> posKeys = reader.readSpan(static_cast<size_t>(posKeyCount) * 4, scratch);
+
+        seq.posKeys.resize(posKeyCount);
+        for (size_t i = 0; i < posKeys.size() / 4; ++i)
+        {
+            const float* key = posKeys.data() + i * 4;
+
+            seq.posKeys[i].time = key[0];
+            seq.posKeys[i].position.set(key[1], key[2], key[3]);
+        }
+    }
+
+    PRS::PRS(const ByteArray& fileContents, std::string filename)
     {
         auto log = spdlog::get("log");
 
@@ -87,19 +115,7 @@ namespace ehb
 
                 log->debug("rootKey has {} positional keys and {} rotational keys", posKeyCount, rotKeyCount);
 
-                rKeyListSeq.rotKeys.resize(rotKeyCount);
-                for (auto& key : rKeyListSeq.rotKeys)
-                {
-                    key.time = reader.readFloat32();
-                    key.rotation = reader.readQuat();
-                }
-
-                rKeyListSeq.posKeys.resize(posKeyCount);
-                for (auto& key : rKeyListSeq.posKeys)
-                {
-                    key.time = reader.readFloat32();
-                    key.position = reader.readVec3();
-                }
+                readKeys(reader, rKeyListSeq, rotKeyCount, posKeyCount);
             }
             else if (chunkId == "KLST")
             {
@@ -113,22 +129,7 @@ namespace ehb
 
                 log->debug("bone {} has {} positional keys and {} rotation keys", boneIndex, posKeyCount, rotKeyCount);
 
-                AnimSeq& seq = kListSeq[boneIndex];
-
-                seq.rotKeys.resize(rotKeyCount);
-                seq.posKeys.resize(posKeyCount);
-
-                for (auto& key : seq.rotKeys)
-                {
-                    key.time = reader.readFloat32();
-                    key.rotation = reader.readQuat();
-                }
-
-                for (auto& key: seq.posKeys)
-                {
-                    key.time = reader.readFloat32();
-                    key.position = reader.readVec3();
-                }
+                readKeys(reader, kListSeq[boneIndex], rotKeyCount, posKeyCount);
 
             }
             else if (chunkId == "AEND")
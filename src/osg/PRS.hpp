@@ -14,7 +14,7 @@ namespace ehb
     // I'd like to get rid of the below to cut out the intermediate but this is good in case we need to query the animation
     struct PRS final
     {
-        PRS(ByteArray fileContents, std::string filename = "");
+        PRS(const ByteArray& fileContents, std::string filename = "");
         ~PRS() = default;
 
         // "Raw" version numbers of the ASP sections.
@@ -6,6 +6,9 @@
 #include <osg/ComputeBoundsVisitor>
 #include <osg/PolygonMode>
 #include <osg/PolygonOffset>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
 
 #include <spdlog/spdlog.h>
 
@@ -39,6 +42,111 @@ namespace ehb
         return group.release();
     }
 
+    bool SiegeNodeMesh::segmentHitsBox(const osg::BoundingBox& box, const osg::Vec3& start, const osg::Vec3& direction, float farRatio)
+    {
+        float nearRatio = 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (direction[axis] == 0)
+            {
+                if (start[axis] < box._min[axis] || start[axis] > box._max[axis]) return false;
+
+                continue;
+            }
+
+            const float inverse = 1.0f / direction[axis];
+
+            float t0 = (box._min[axis] - start[axis]) * inverse, t1 = (box._max[axis] - start[axis]) * inverse;
+
+            if (t0 > t1) std::swap(t0, t1);
+
+            nearRatio = std::max(nearRatio, t0);
+            farRatio = std::min(farRatio, t1);
+
+            if (nearRatio > farRatio) return false;
+        }
+
+        return true;
+    }
+
+    //! moller-trumbore with both sides of the face counting, ratio is lowered to the hit if it is closer
+    static bool segmentHitsFace(const SiegeNodeMesh::Face& face, const osg::Vec3& start, const osg::Vec3& direction, float& ratio)
+    {
+        const osg::Vec3 edge1 = face.b - face.a, edge2 = face.c - face.a;
+        const osg::Vec3 p = direction ^ edge2;
+
+        const float determinant = edge1 * p;
+
+        // the segment runs along the face
+        if (std::abs(determinant) < 1e-12f) return false;
+
+        const float inverse = 1.0f / determinant;
+        const osg::Vec3 s = start - face.a;
+
+        const float u = (s * p) * inverse;
+        if (u < 0 || u > 1) return false;
+
+        const osg::Vec3 q = s ^ edge1;
+
+        const float v = (direction * q) * inverse;
+        if (v < 0 || u + v > 1) return false;
+
+        const float t = (edge2 * q) * inverse;
+        if (t < 0 || t > ratio) return false;
+
+        ratio = t;
+
+        return true;
+    }
+
+    //! @param ratio the closest hit so far, lowered along with face when something closer is found in this logical node
+    static bool intersectGrouping(const SiegeNodeMesh::LogicalNodeGrouping& grouping, const osg::Vec3& start, const osg::Vec3& direction, float& ratio, uint32_t& face)
+    {
+        bool found = false;
+
+        const auto test = [&](uint32_t index)
+        {
+            if (segmentHitsFace(grouping.logicalNodeFaces[index], start, direction, ratio))
+            {
+                face = index;
+                found = true;
+            }
+        };
+
+        if (grouping.boxTree.empty())
+        {
+            for (uint32_t index = 0; index < grouping.logicalNodeFaces.size(); ++index)
+            {
+                test(index);
+            }
+
+            return found;
+        }
+
+        for (uint32_t i = 0; i < grouping.boxTree.size();)
+        {
+            const SiegeNodeMesh::BoxTreeNode& box = grouping.boxTree[i];
+
+            // a closer hit shrinks the segment so boxes further along it are skipped too
+            if (!SiegeNodeMesh::segmentHitsBox(box.bbox, start, direction, ratio))
+            {
+                i = box.skip;
+
+                continue;
+            }
+
+            for (uint32_t j = 0; j < box.faceCount; ++j)
+            {
+                test(grouping.indices[box.firstFace + j]);
+            }
+
+            i++;
+        }
+
+        return found;
+    }
+
     // custom compute our bounding box as what OSG does by default seems to be larger than what the actual node is
     osg::BoundingSphere SiegeNodeMesh::computeBound() const
     {
@@ -62,30 +170,20 @@ namespace ehb
         if (!targetMesh) { log->error("SiegeNode::connect - targetNode has no SiegeNode parent"); return; }
         if (!connectMesh) { log->error("SiegeNode::connect - connectNode has no SiegeNode parent"); return; }
 
-        const osg::Matrix* m1 = nullptr, * m2 = nullptr;
-
-        for (const auto& entry : targetMesh->doorXform)
-        {
-            if (entry.first == targetDoor)
-            {
-                m1 = &entry.second;
-                break;
-            }
-        }
+        const osg::Matrix* m1 = targetMesh->doorMatrix(targetDoor);
 
         if (!m1) { log->error("couldn't find targetDoor {}", targetDoor); return; }
 
-        for (const auto& entry : connectMesh->doorXform)
-        {
-            if (entry.first == connectDoor)
-            {
-                m2 = &entry.second;
-                break;
-            }
-        }
+        const osg::Matrix* m2 = connectMesh->doorMatrix(connectDoor);
 
         if (!m2) { log->error("couldn't find connectDoor {}", connectDoor); return; }
 
+        // "Hold on to your butts." - Ray Arnold
+        connectNode->setMatrix(connectMatrix(*m1, *m2, targetNode->getMatrix()));
+    }
+
+    osg::Matrix SiegeNodeMesh::connectMatrix(const osg::Matrix& targetDoor, const osg::Matrix& connectDoor, const osg::Matrix& target)
+    {
         osg::Matrix xform;
 
         /*
@@ -94,47 +192,66 @@ namespace ehb
          * we're currently placing the center of connectNode at the location
          * of its door and will be connecting this to door 1
          */
-        xform = osg::Matrix::inverse(*m2);
+        xform = osg::Matrix::inverse(connectDoor);
 
         // account for flipping from door 1 to door 2
         xform.postMultRotate(osg::Quat(osg::DegreesToRadians(180.0), osg::Vec3(0, 1, 0)));
 
         // now transform by the first door...
-        xform.postMult(*m1);
+        xform.postMult(targetDoor);
 
         // and adjust for the node we're connecting to
-        xform.postMult(targetNode->getMatrix());
+        xform.postMult(target);
 
-        // "Hold on to your butts." - Ray Arnold
-        connectNode->setMatrix(xform);
+        return xform;
     }
 
-    void SiegeNodeMesh::toggleAllDoorLabels()
+    osg::Group* SiegeNodeMesh::debugDoorLabels()
     {
-        if (!drawingDoorLabels)
+        if (debugDrawingGroups[0] == nullptr)
         {
-            if (debugDrawingGroups[0] == nullptr)
-            {
-                debugDrawingGroups[0] = new osg::Group;
+            debugDrawingGroups[0] = new osg::Group;
 
-                for (const auto& entry : doorXform)
-                {
-                    osg::ref_ptr<osgText::Text> text = new osgText::Text;
-                    text->setAxisAlignment(osgText::Text::SCREEN);
-                    text->setCharacterSize(1);
-                    text->setText(std::to_string(entry.first));
-                    text->getOrCreateStateSet()->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+            for (const auto& entry : doorXform)
+            {
+                osg::ref_ptr<osgText::Text> text = new osgText::Text;
+                text->setAxisAlignment(osgText::Text::SCREEN);
+                text->setCharacterSize(1);
+                text->setText(std::to_string(entry.first));
+                text->getOrCreateStateSet()->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
 
-                    const auto doorXform = getMatrixForDoorId(entry.first);
+                const auto doorXform = getMatrixForDoorId(entry.first);
 
-                    osg::ref_ptr<osg::MatrixTransform> doorMatTransform = new osg::MatrixTransform(doorXform);
-                    doorMatTransform->addChild(text);
+                osg::ref_ptr<osg::MatrixTransform> doorMatTransform = new osg::MatrixTransform(doorXform);
+                doorMatTransform->addChild(text);
 
-                    debugDrawingGroups[0]->addChild(doorMatTransform);
-                }
+                debugDrawingGroups[0]->addChild(doorMatTransform);
             }
+        }
 
-            addChild(debugDrawingGroups[0]);
+        return debugDrawingGroups[0].get();
+    }
+
+    osg::Group* SiegeNodeMesh::debugBoundingBox()
+    {
+        if (debugDrawingGroups[1] == nullptr)
+        {
+            debugDrawingGroups[1] = new osg::Group;
+
+            osg::ComputeBoundsVisitor cbv;
+            accept(cbv);
+
+            debugDrawingGroups[1]->addChild(createBoxForDebug(cbv.getBoundingBox()._min, cbv.getBoundingBox()._max));
+        }
+
+        return debugDrawingGroups[1].get();
+    }
+
+    void SiegeNodeMesh::toggleAllDoorLabels()
+    {
+        if (!drawingDoorLabels)
+        {
+            addChild(debugDoorLabels());
 
             drawingDoorLabels = true;
 
@@ -156,17 +273,7 @@ namespace ehb
     {
         if (!drawingBoundingBox)
         {
-            if (debugDrawingGroups[1] == nullptr)
-            {
-                debugDrawingGroups[1] = new osg::Group;
-
-                osg::ComputeBoundsVisitor cbv;
-                accept(cbv);
-
-                debugDrawingGroups[1]->addChild(createBoxForDebug(cbv.getBoundingBox()._min, cbv.getBoundingBox()._max));
-            }
-
-            addChild(debugDrawingGroups[1]);
+            addChild(debugBoundingBox());
 
             drawingBoundingBox = true;
 
@@ -248,17 +355,102 @@ namespace ehb
         }
     }
 
-    const osg::Matrix SiegeNodeMesh::getMatrixForDoorId(const uint32_t id) const
+    bool SiegeNodeMesh::intersect(const osg::Vec3& start, const osg::Vec3& end, FaceHit& hit, uint32_t flagMask) const
+    {
+        const osg::Vec3 direction = end - start;
+
+        const LogicalNodeGrouping* found = nullptr;
+        uint32_t face = 0;
+        float ratio = 1;
+
+        for (const auto& grouping : logicalNodeGroupings)
+        {
+            const uint32_t flag = static_cast<uint32_t>(grouping.flag);
+
+            // the ignored bit can show up alongside the others so it has to be asked for on its own
+            if ((flag & flagMask) == 0 || (flag & ~flagMask & static_cast<uint32_t>(FloorFlag::FLOOR_IGNORED)) != 0) continue;
+
+            if (segmentHitsBox(grouping.bbox, start, direction, ratio) && intersectGrouping(grouping, start, direction, ratio, face))
+            {
+                found = &grouping;
+            }
+        }
+
+        if (found == nullptr) return false;
+
+        hit.grouping = found;
+        hit.face = face;
+        hit.ratio = ratio;
+        hit.position = start + direction * ratio;
+        hit.normal = found->logicalNodeFaces[face].normal;
+
+        return true;
+    }
+
+    bool SiegeNodeMesh::faceBelow(const osg::Vec3& point, FaceHit& hit, uint32_t flagMask) const
+    {
+        if (!logicalBounds.valid() || point.y() < logicalBounds.yMin()) return false;
+
+        return intersect(point, osg::Vec3(point.x(), logicalBounds.yMin() - 1.0f, point.z()), hit, flagMask);
+    }
+
+    SiegeNodeMesh::Footprint SiegeNodeMesh::footprint() const
     {
-        for (const auto& entry : doorXform)
+        std::unordered_set<const osg::BufferData*> counted;
+        Footprint result;
+
+        auto add = [&counted](size_t& total, const osg::BufferData* data)
+        {
+            if (data != nullptr && counted.insert(data).second)
+            {
+                total += data->getTotalDataSize();
+            }
+        };
+
+        for (unsigned int i = 0; i < getNumChildren(); ++i)
         {
-            if (entry.first == id)
+            if (const osg::Geometry* geometry = getChild(i)->asGeometry())
             {
-                return entry.second;
-                break;
+                add(result.vertexBytes, geometry->getVertexArray());
+                add(result.vertexBytes, geometry->getNormalArray());
+                add(result.vertexBytes, geometry->getColorArray());
+
+                for (unsigned int unit = 0; unit < geometry->getNumTexCoordArrays(); ++unit)
+                {
+                    add(result.vertexBytes, geometry->getTexCoordArray(unit));
+                }
+
+                for (unsigned int j = 0; j < geometry->getNumPrimitiveSets(); ++j)
+                {
+                    if (const osg::DrawElements* elements = geometry->getPrimitiveSet(j)->getDrawElements())
+                    {
+                        add(result.indexBytes, elements);
+                    }
+                }
             }
         }
 
+        for (const auto& grouping : logicalNodeGroupings)
+        {
+            result.faceBytes += grouping.logicalNodeFaces.size() * sizeof(Face);
+            result.faceBytes += grouping.leaves.size() * sizeof(Leaf) + grouping.leafConnections.size() * sizeof(LeafConnection);
+            result.faceBytes += grouping.boxTree.size() * sizeof(BoxTreeNode) + grouping.indices.size() * sizeof(uint16_t);
+        }
+
+        return result;
+    }
+
+    const osg::Matrix SiegeNodeMesh::getMatrixForDoorId(const uint32_t id) const
+    {
+        if (const osg::Matrix* matrix = doorMatrix(id)) return *matrix;
+
         return osg::Matrix::identity();
     }
+
+    const osg::Matrix* SiegeNodeMesh::doorMatrix(uint32_t id) const
+    {
+        const auto itr = std::lower_bound(doorXform.begin(), doorXform.end(), id, [](const auto& entry, uint32_t id) { return entry.first < id; });
+
+        return itr != doorXform.end() && itr->first == id ? &itr->second : nullptr;
+    }
 }
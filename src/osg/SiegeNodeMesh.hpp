@@ -23,6 +23,39 @@ namespace ehb
             FLOOR_WATER = 2147483648
         };
 
+        //! a patch of the faces of a logical node
+        struct Leaf final
+        {
+            uint16_t id = 0;
+            osg::BoundingBox bbox;
+            osg::Vec3 center;
+
+            uint32_t firstNeighbour = 0;    //!< the ids of the leaves it connects to, in LogicalNodeGrouping::indices
+            uint32_t neighbourCount = 0;
+            uint32_t firstFace = 0;         //!< the faces it is made of, in LogicalNodeGrouping::indices
+            uint32_t faceCount = 0;
+        };
+
+        //! a leaf of this logical node touching a leaf of another logical node in the same mesh
+        struct LeafConnection final
+        {
+            uint8_t farId = 0;
+            uint16_t leaf = 0;
+            uint16_t farLeaf = 0;
+        };
+
+        /*
+         * the box tree stored after the faces of each logical node, kept in the order the file lists it. the children of a
+         * box follow it and skip is the first box past all of them so a query walks it front to back without a stack
+         */
+        struct BoxTreeNode final
+        {
+            osg::BoundingBox bbox;          //!< grown on load to hold its faces and children if the file's didn't
+            uint32_t skip = 0;
+            uint32_t firstFace = 0;         //!< in LogicalNodeGrouping::indices
+            uint32_t faceCount = 0;
+        };
+
         struct LogicalNodeGrouping final : public osg::Group
         {
             uint8_t id = 0;
@@ -33,6 +66,25 @@ namespace ehb
             osg::BoundingBox bbox;
 
             std::vector<Face> logicalNodeFaces;           
+
+            std::vector<Leaf> leaves;
+            std::vector<LeafConnection> leafConnections;
+
+            //! empty when the tree in the file doesn't reach every face, queries then test the faces one by one
+            std::vector<BoxTreeNode> boxTree;
+
+            //! the face and leaf ids the leaves and boxes point into
+            std::vector<uint16_t> indices;
+        };
+
+        //! a logical node face found by a query, in the space of the mesh
+        struct FaceHit final
+        {
+            const LogicalNodeGrouping* grouping = nullptr;
+            uint32_t face = 0;              //!< in grouping->logicalNodeFaces
+            float ratio = 0;                //!< how far along the segment the face is
+            osg::Vec3 position;
+            osg::Vec3 normal;
         };
 
     public:
@@ -43,6 +95,9 @@ namespace ehb
 
         static void connect(osg::MatrixTransform* targetNode, uint32_t targetDoor, osg::MatrixTransform* connectNode, uint32_t connectDoor);
 
+        //! where connectNode goes when its connectDoor is joined to targetDoor of a node placed at target, doors in the space of their meshes
+        static osg::Matrix connectMatrix(const osg::Matrix& targetDoor, const osg::Matrix& connectDoor, const osg::Matrix& target);
+
         virtual osg::BoundingSphere computeBound() const override;
 
         void toggleAllDoorLabels();
@@ -51,6 +106,64 @@ namespace ehb
 
         void toggleLogicalNodeFlags();
 
+        /*
+         * the door labels and bounding box the toggles above draw, built the first time they are asked for. they are in the
+         * space of the mesh so adding one under the transform of a node draws it for that node alone
+         */
+        osg::Group* debugDoorLabels();
+        osg::Group* debugBoundingBox();
+
+        //! true while any of the debug groups above is switched on
+        bool drawingDebugGroups() const;
+
+        /*
+         * the floor and water bits of a logical node flag. FLOOR_FLOOR also sets bit 0 which isn't part of the mask as an
+         * ignored node can carry it too
+         */
+        static constexpr uint32_t walkableFlags = 0x40000000 | 0x80000000;
+
+        //! floor or water and not ignored
+        static bool walkable(FloorFlag flag);
+
+        /*
+         * the first logical node face on the segment from start to end, culled by the logical node boxes and their trees
+         *
+         * @param flagMask only logical nodes with one of these flags set are looked at, ignored ones only if the mask has FLOOR_IGNORED
+         */
+        bool intersect(const osg::Vec3& start, const osg::Vec3& end, FaceHit& hit, uint32_t flagMask = ~0u) const;
+
+        //! the closest logical node face at or straight below point
+        bool faceBelow(const osg::Vec3& point, FaceHit& hit, uint32_t flagMask = ~0u) const;
+
+        //! whether the segment start + ratio * direction for ratios from 0 to farRatio passes through box
+        static bool segmentHitsBox(const osg::BoundingBox& box, const osg::Vec3& start, const osg::Vec3& direction, float farRatio);
+
+        //! bytes held by each kind of geometry data, arrays shared between geometries are only counted once
+        struct Footprint final
+        {
+            size_t vertexBytes = 0;     //!< positions, normals, colors and texture coordinates
+            size_t indexBytes = 0;
+            size_t faceBytes = 0;       //!< logical node faces, their leaves and box trees
+
+            size_t total() const;
+
+            Footprint& operator += (const Footprint& other);
+        };
+
+        Footprint footprint() const;
+
+        //! where a door sits in the space of the mesh, identity if the mesh has no such door
+        const osg::Matrix getMatrixForDoorId(const uint32_t id) const;
+
+        //! where a door sits in the space of the mesh, nullptr if the mesh has no such door
+        const osg::Matrix* doorMatrix(uint32_t id) const;
+
+        //! every door and where it sits, sorted by id
+        const std::vector<std::pair<uint32_t, osg::Matrix>>& doorMatrices() const;
+
+        //! bytes held by the vertex, index and logical face data
+        size_t geometryBytes() const;
+
         //! TODO: private
         std::vector<LogicalNodeGrouping> logicalNodeGroupings;
 
@@ -60,12 +173,12 @@ namespace ehb
 
     private:
 
-        const osg::Matrix getMatrixForDoorId(const uint32_t id) const;
-
-    private:
-
+        //! sorted by id on load
         std::vector<std::pair<uint32_t, osg::Matrix>> doorXform;
 
+        //! holds every logical node face
+        osg::BoundingBox logicalBounds;
+
         /*
          * 0 = doors
          * 1 = bounding box
@@ -81,4 +194,40 @@ namespace ehb
     {
         debugDrawingGroups.resize(3);
     }
+
+    inline bool SiegeNodeMesh::drawingDebugGroups() const
+    {
+        return drawingDoorLabels || drawingBoundingBox || drawingLogicalNodeFlags;
+    }
+
+    inline bool SiegeNodeMesh::walkable(FloorFlag flag)
+    {
+        const uint32_t bits = static_cast<uint32_t>(flag);
+
+        return (bits & walkableFlags) != 0 && (bits & static_cast<uint32_t>(FloorFlag::FLOOR_IGNORED)) == 0;
+    }
+
+    inline const std::vector<std::pair<uint32_t, osg::Matrix>>& SiegeNodeMesh::doorMatrices() const
+    {
+        return doorXform;
+    }
+
+    inline size_t SiegeNodeMesh::Footprint::total() const
+    {
+        return vertexBytes + indexBytes + faceBytes;
+    }
+
+    inline SiegeNodeMesh::Footprint& SiegeNodeMesh::Footprint::operator += (const Footprint& other)
+    {
+        vertexBytes += other.vertexBytes;
+        indexBytes += other.indexBytes;
+        faceBytes += other.faceBytes;
+
+        return *this;
+    }
+
+    inline size_t SiegeNodeMesh::geometryBytes() const
+    {
+        return footprint().total();
+    }
 }
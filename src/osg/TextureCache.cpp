@@ -0,0 +1,209 @@
+
+#include "TextureCache.hpp"
+
+#include <osg/Image>
+#include <osg/State>
+#include <osg/StateSet>
+#include <osg/Texture2D>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/ReadFile>
+
+namespace ehb
+{
+    //! counts the first time the texture is applied in each context, that is when osg sends the image to it
+    class TextureCache::CountedTexture final : public osg::Texture2D
+    {
+    public:
+
+        CountedTexture(osg::Image* image) : osg::Texture2D(image)
+        {
+        }
+
+        virtual void apply(osg::State& state) const override
+        {
+            const unsigned int contextID = state.getContextID();
+            const bool resident = getTextureObject(contextID) != nullptr;
+
+            osg::Texture2D::apply(state);
+
+            if (!resident && getTextureObject(contextID) != nullptr)
+            {
+                TextureCache& cache = TextureCache::instance();
+
+                cache.uploads++;
+
+                if (const osg::Image* image = getImage())
+                {
+                    cache.uploadBytes += image->getTotalSizeInBytes();
+                }
+            }
+        }
+    };
+
+    TextureCache& TextureCache::instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    osg::ref_ptr<osg::Image> TextureCache::image(const std::string& fileName)
+    {
+        requests++;
+
+        // the same image is asked for by its naming key, by its full path and in whatever case the gas files used
+        std::string resolved = osgDB::findDataFile(fileName);
+
+        if (resolved.empty()) resolved = fileName;
+
+        const std::string key = osgDB::convertToLowerCase(resolved);
+
+        osg::ref_ptr<osg::Image> result;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (const auto itr = images.find(key); itr != images.end() && itr->second.lock(result))
+            {
+                hits++;
+                requestedBytes += result->getTotalSizeInBytes();
+
+                return result;
+            }
+        }
+
+        // decoding happens outside of the lock so regions paging in on other threads aren't held up behind it
+        result = osgDB::readRefImageFile(resolved);
+
+        if (result == nullptr) return nullptr;
+
+        requestedBytes += result->getTotalSizeInBytes();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // if another thread finished decoding the same image first use its copy so there is still only one
+        osg::observer_ptr<osg::Image>& entry = images[key];
+
+        if (osg::ref_ptr<osg::Image> existing; entry.lock(existing))
+        {
+            hits++;
+
+            return existing;
+        }
+
+        entry = result;
+
+        return result;
+    }
+
+    osg::ref_ptr<osg::Texture2D> TextureCache::texture(const std::string& fileName, Wrap wrap)
+    {
+        return texture(image(fileName).get(), wrap);
+    }
+
+    osg::ref_ptr<osg::Texture2D> TextureCache::texture(osg::Image* image, Wrap wrap)
+    {
+        if (image == nullptr) return nullptr;
+
+        requests++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        osg::observer_ptr<osg::Texture2D>& entry = textures[Key(image, wrap)];
+
+        osg::ref_ptr<osg::Texture2D> result;
+
+        if (entry.lock(result))
+        {
+            hits++;
+
+            return result;
+        }
+
+        result = new CountedTexture(image);
+
+        if (wrap == Wrap::Repeat)
+        {
+            result->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
+            result->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
+        }
+
+        entry = result;
+
+        return result;
+    }
+
+    osg::ref_ptr<osg::StateSet> TextureCache::stateSet(const std::string& fileName, Wrap wrap)
+    {
+        osg::ref_ptr<osg::Texture2D> texture = this->texture(fileName, wrap);
+
+        if (texture == nullptr) return nullptr;
+
+        requests++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        osg::observer_ptr<osg::StateSet>& entry = stateSets[Key(texture->getImage(), wrap)];
+
+        osg::ref_ptr<osg::StateSet> result;
+
+        if (entry.lock(result))
+        {
+            hits++;
+
+            return result;
+        }
+
+        result = new osg::StateSet;
+        result->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+
+        entry = result;
+
+        return result;
+    }
+
+    void TextureCache::prune()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto expired = [](auto& map)
+        {
+            for (auto itr = map.begin(); itr != map.end();)
+            {
+                if (itr->second.valid()) ++itr;
+                else itr = map.erase(itr);
+            }
+        };
+
+        expired(images);
+        expired(textures);
+        expired(stateSets);
+    }
+
+    TextureCache::Stats TextureCache::stats() const
+    {
+        Stats result;
+
+        result.requests = requests;
+        result.hits = hits;
+        result.requestedBytes = requestedBytes;
+        result.uploads = uploads;
+        result.uploadBytes = uploadBytes;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const auto& entry : images)
+        {
+            if (osg::ref_ptr<osg::Image> image; entry.second.lock(image))
+            {
+                result.images++;
+                result.imageBytes += image->getTotalSizeInBytes();
+            }
+        }
+
+        for (const auto& entry : textures) if (entry.second.valid()) result.textures++;
+        for (const auto& entry : stateSets) if (entry.second.valid()) result.stateSets++;
+
+        return result;
+    }
+}
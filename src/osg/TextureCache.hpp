@@ -0,0 +1,90 @@
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <osg/observer_ptr>
+#include <osg/ref_ptr>
+
+namespace osg
+{
+    class Image;
+    class StateSet;
+    class Texture2D;
+}
+
+namespace ehb
+{
+    /*
+     * every image, texture and state set handed out for a .raw file goes through here so terrain and ui art that is used
+     * by many meshes and widgets is decoded, stored and uploaded once
+     *
+     * images are keyed by the filename osg resolves them to, textures and state sets by their image and wrap mode. the cache
+     * only observes what it hands out so anything no mesh or widget is using anymore is freed as usual. what is handed out
+     * is shared so it must not be modified, ask for the other wrap mode instead of changing it on a texture
+     */
+    class TextureCache final
+    {
+    public:
+
+        enum class Wrap
+        {
+            Clamp,  //!< the osg default
+            Repeat
+        };
+
+        struct Stats
+        {
+            size_t requests = 0;        //!< image, texture and state set requests
+            size_t hits = 0;            //!< requests answered with something already in the cache
+            size_t images = 0;          //!< images, textures and state sets still in use
+            size_t textures = 0;
+            size_t stateSets = 0;
+            size_t imageBytes = 0;      //!< decoded size of every image still in use, each counted once
+            size_t requestedBytes = 0;  //!< decoded size of every image request, what would be held without sharing
+            size_t uploads = 0;         //!< times a cached texture has been sent to a graphics context
+            size_t uploadBytes = 0;
+        };
+
+        TextureCache(TextureCache&&) = delete;
+        TextureCache(const TextureCache&) = delete;
+
+        TextureCache& operator = (TextureCache&&) = delete;
+        TextureCache& operator = (const TextureCache&) = delete;
+
+        static TextureCache& instance();
+
+        //! @return nullptr if the image can't be read, failures aren't cached
+        osg::ref_ptr<osg::Image> image(const std::string& fileName);
+
+        osg::ref_ptr<osg::Texture2D> texture(const std::string& fileName, Wrap wrap);
+        osg::ref_ptr<osg::Texture2D> texture(osg::Image* image, Wrap wrap);
+
+        //! a state set with only the texture on unit 0 so every drawable using it can share all of its state
+        osg::ref_ptr<osg::StateSet> stateSet(const std::string& fileName, Wrap wrap);
+
+        //! forget the entries for everything that has been freed since
+        void prune();
+
+        Stats stats() const;
+
+    private:
+
+        TextureCache() = default;
+
+        class CountedTexture;
+
+        using Key = std::pair<const osg::Image*, Wrap>;
+
+        mutable std::mutex mutex;
+
+        std::unordered_map<std::string, osg::observer_ptr<osg::Image>> images;
+        std::map<Key, osg::observer_ptr<osg::Texture2D>> textures;
+        std::map<Key, osg::observer_ptr<osg::StateSet>> stateSets;
+
+        std::atomic<size_t> requests{ 0 }, hits{ 0 }, requestedBytes{ 0 }, uploads{ 0 }, uploadBytes{ 0 };
+    };
+}
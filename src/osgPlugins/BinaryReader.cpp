@@ -40,21 +40,24 @@ namespace ehb
 
 namespace ehb
 {
-    BinaryReader::BinaryReader(ByteArray fileData) : fileContents(fileData), readPosition(0)
+    BinaryReader::BinaryReader(const uint8_t* data, size_t size) : fileContents(data), fileSize(size)
     {
         swap = (osg::getCpuByteOrder() == osg::BigEndian);
     }
 
+    BinaryReader::BinaryReader(const ByteArray& fileData) : BinaryReader(fileData.data(), fileData.size())
+    {
+    }
+
     void BinaryReader::readBytes(void* buffer, size_t numBytes)
     {
-        if (readPosition == fileContents.size() || (readPosition + numBytes) > fileContents.size())
+        if (remaining() < numBytes)
         {
             // out of bytes to read
             return;
         }
 
-        const uint8_t* dataPtr = fileContents.data() + readPosition;
-        std::memcpy(buffer, dataPtr, numBytes);
+        std::memcpy(buffer, fileContents + readPosition, numBytes);
         readPosition += numBytes;
     }
 
@@ -63,13 +66,40 @@ namespace ehb
         readPosition += numBytes;
     }
 
+    const uint8_t* BinaryReader::take(size_t size, size_t count)
+    {
+        // dividing instead of multiplying means a garbage count can't overflow past the check
+        if (remaining() / size < count)
+        {
+            readPosition = fileSize;
+
+            return nullptr;
+        }
+
+        const uint8_t* data = fileContents + readPosition;
+        readPosition += size * count;
+
+        return data;
+    }
+
+    void BinaryReader::swapFields(void* data, size_t numBytes, size_t fieldSize)
+    {
+        char* bytes = static_cast<char*>(data);
+
+        switch (fieldSize)
+        {
+            case 2: for (size_t i = 0; i < numBytes; i += 2) osg::swapBytes2(bytes + i); break;
+            case 4: for (size_t i = 0; i < numBytes; i += 4) osg::swapBytes4(bytes + i); break;
+            case 8: for (size_t i = 0; i < numBytes; i += 8) osg::swapBytes8(bytes + i); break;
+            default: break;
+        }
+    }
+
     uint8_t BinaryReader::readUInt8()
     {
         uint8_t read = 0;
         readBytes(&read, sizeof(read));
 
-        if (swap) osg::swapBytes((char *)&read, 1);
-
         return read;
     }
 
@@ -115,14 +145,13 @@ namespace ehb
 
     bool BinaryReader::readFourCC(FourCC& fcc)
     {
-        if (readPosition == fileContents.size() || (readPosition + sizeof(FourCC)) > fileContents.size())
+        if (remaining() < sizeof(FourCC))
         {
             // out of bytes to read
             return false;
         }
 
-        const unsigned char* dataPtr = fileContents.data() + readPosition;
-        std::memcpy(&fcc, dataPtr, sizeof(FourCC));
+        std::memcpy(&fcc, fileContents + readPosition, sizeof(FourCC));
         readPosition += sizeof(FourCC);
 
         return true;
@@ -130,40 +159,46 @@ namespace ehb
 
     osg::Vec2 BinaryReader::readVec2()
     {
-        float read[2];
+        float read[2] = { 0.0f, 0.0f };
         readBytes(&read, sizeof(read));
 
+        if (swap) swapFields(read, sizeof(read), sizeof(float));
+
         return osg::Vec2(read[0], read[1]);
     }
+
     osg::Vec3 BinaryReader::readVec3()
     {
         osg::Vec3 v;
         readBytes(&v, sizeof(osg::Vec3));
+
+        if (swap) swapFields(&v, sizeof(v), sizeof(float));
+
         return v;
     }
+
     osg::Quat BinaryReader::readQuat()
     {
-        float read[4];
+        float read[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
         readBytes(&read, sizeof(read));
+
+        if (swap) swapFields(read, sizeof(read), sizeof(float));
+
         return osg::Quat(read[0], read[1], read[2], read[3]);
     }
 
     std::string BinaryReader::readString()
     {
-        // std::getline ???
+        if (remaining() == 0) return {};
 
-        std::string tmp;
-        for (;;)
-        {
-            char c = '\0';
-            readBytes(&c, 1);
-            if (c == '\0')
-            {
-                break;
-            }
-            tmp.push_back(c);
-        }
+        const char* begin = reinterpret_cast<const char*>(fileContents + readPosition);
+
+        // a string missing its terminator runs to the end of the data
+        const void* terminator = std::memchr(begin, '\0', remaining());
+        const size_t length = terminator != nullptr ? static_cast<const char*>(terminator) - begin : remaining();
+
+        readPosition += terminator != nullptr ? length + 1 : length;
 
-        return tmp;
+        return std::string(begin, length);
     }
 }
@@ -4,9 +4,12 @@
 #include <vector>
 #include <osg/Vec2>
 #include <osg/Vec3>
+#include <osg/Vec4>
 #include <osg/Quat>
+#include <cstdint>
 #include <cstring>
 #include <string>
+#include <type_traits>
 
 namespace ehb
 {
@@ -57,16 +60,68 @@ namespace ehb
 
     using ByteArray = std::vector<uint8_t>;
 
+    //! a read only view of count values that lives somewhere else, either inside the file being read or a caller's scratch buffer
+    template <typename T>
+    class Span final
+    {
+    public:
+
+        Span() = default;
+        Span(const T* data, size_t size) : ptr(data), count(size) {}
+
+        const T* data() const { return ptr; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        const T& operator [] (size_t index) const { return ptr[index]; }
+
+        const T* begin() const { return ptr; }
+        const T* end() const { return ptr + count; }
+
+    private:
+
+        const T* ptr = nullptr;
+        size_t count = 0;
+    };
+
+    /*
+     * the size of each field in T that has to be byte swapped on a big endian cpu
+     * only types made of one kind of field can be read in bulk, anything else is read a field at a time
+     */
+    template <typename T> struct FieldSize : std::integral_constant<size_t, sizeof(T)>
+    {
+        static_assert(std::is_arithmetic<T>::value, "bulk reads need a FieldSize for this type");
+    };
+
+    template <> struct FieldSize<osg::Vec2> : std::integral_constant<size_t, sizeof(float)> {};
+    template <> struct FieldSize<osg::Vec3> : std::integral_constant<size_t, sizeof(float)> {};
+    template <> struct FieldSize<osg::Vec4> : std::integral_constant<size_t, sizeof(float)> {};
+
+    /*
+     * reads little endian data out of memory owned by someone else, nothing is copied on construction so the data has to
+     * outlive the reader
+     *
+     * single reads that run past the end read nothing and leave the position where it was, bulk reads that run past the
+     * end read nothing and move the position to the end so everything after them fails as well
+     */
     class BinaryReader final
     {
     public:
 
-        BinaryReader(ByteArray fileData);
+        BinaryReader(const uint8_t* data, size_t size);
+        BinaryReader(const ByteArray& fileData);
+
+        //! a temporary would be gone before the first read
+        BinaryReader(ByteArray&&) = delete;
+
         ~BinaryReader() = default;
 
         void readBytes(void* buffer, size_t numBytes);
         void skipBytes(const size_t numBytes);
 
+        size_t position() const;
+        size_t remaining() const;
+
         uint8_t readUInt8();
         uint16_t readUInt16();
         uint32_t readUInt32();
@@ -81,11 +136,99 @@ namespace ehb
 
         std::string readString();
 
+        //! copy count values into out with one bounds check, out is left alone if there aren't that many
+        template <typename T>
+        bool readArray(T* out, size_t count);
+
+        //! like the single reads the values are zero if there weren't enough bytes left
+        template <typename T>
+        std::vector<T> readArray(size_t count);
+
+        /*
+         * count values straight out of the file when they can be used in place, otherwise they are decoded into scratch
+         * and the span points there. it's only valid until the data or scratch goes away
+         */
+        template <typename T>
+        Span<T> readSpan(size_t count, std::vector<T>& scratch);
+
     private:
 
+        //! @return where count values of T start or nullptr after moving to the end if there aren't that many left
+        const uint8_t* take(size_t size, size_t count);
+
+        static void swapFields(void* data, size_t numBytes, size_t fieldSize);
+
         bool swap = false;
 
-        size_t readPosition = -1;
-        const ByteArray fileContents;
+        const uint8_t* fileContents = nullptr;
+        size_t fileSize = 0;
+        size_t readPosition = 0;
     };
-}
\ No newline at end of file
+
+    inline size_t BinaryReader::position() const
+    {
+        return readPosition;
+    }
+
+    inline size_t BinaryReader::remaining() const
+    {
+        return readPosition < fileSize ? fileSize - readPosition : 0;
+    }
+
+    template <typename T>
+    inline bool BinaryReader::readArray(T* out, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read in bulk");
+
+        const uint8_t* data = take(sizeof(T), count);
+
+        if (data == nullptr) return false;
+
+        if (count != 0)
+        {
+            std::memcpy(out, data, sizeof(T) * count);
+
+            if (swap) swapFields(out, sizeof(T) * count, FieldSize<T>::value);
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    inline std::vector<T> BinaryReader::readArray(size_t count)
+    {
+        std::vector<T> result(count);
+
+        readArray(result.data(), count);
+
+        return result;
+    }
+
+    template <typename T>
+    inline Span<T> BinaryReader::readSpan(size_t count, std::vector<T>& scratch)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read in bulk");
+
+        if (remaining() / sizeof(T) < count)
+        {
+            readPosition = fileSize;
+
+            return {};
+        }
+
+        const uint8_t* data = fileContents + readPosition;
+
+        // the file bytes can only be used as T directly when they don't need swapping and sit where a T is allowed to
+        if (!swap && reinterpret_cast<uintptr_t>(data) % alignof(T) == 0)
+        {
+            readPosition += sizeof(T) * count;
+
+            return Span<T>(reinterpret_cast<const T*>(data), count);
+        }
+
+        scratch.resize(count);
+        readArray(scratch.data(), count);
+
+        return Span<T>(scratch.data(), count);
+    }
+}
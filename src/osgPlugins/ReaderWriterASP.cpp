@@ -172,13 +172,7 @@ namespace ehb
                 reader.skipBytes(4);
 
                 auto& mesh = aspectImpl->subMeshes[currentSubMeshIndex];
-                mesh.positions.resize(mesh.vertexCount);
-                for (uint32_t v = 0; v < mesh.vertexCount; ++v)
-                {
-                    auto vert = reader.readVec3();
-
-                    mesh.positions[v] = vert;
-                }
+                mesh.positions = reader.readArray<osg::Vec3>(mesh.vertexCount);
             }
             else if (chunkId == "BCRN")
             {
@@ -277,11 +271,7 @@ namespace ehb
 
                 if (Aspect::Impl::versionOf(version) == 22)
                 {
-                    mesh.faceInfo.cornerSpan.resize(mesh.textureCount);
-                    for (uint32_t i = 0; i < mesh.textureCount; ++i)
-                    {
-                        mesh.faceInfo.cornerSpan[i] = reader.readUInt32();
-                    }
+                    mesh.faceInfo.cornerSpan = reader.readArray<uint32_t>(mesh.textureCount);
 
                     mesh.faceInfo.cornerStart.resize(mesh.textureCount);
                     mesh.faceInfo.cornerStart[0] = 0;
@@ -312,16 +302,15 @@ namespace ehb
                     }
                 }
 
+                std::vector<uint32_t> indexScratch;
+                const Span<uint32_t> indices = reader.readSpan(static_cast<size_t>(mesh.faceCount) * 3, indexScratch);
+
                 mesh.faceInfo.cornerIndex.resize(mesh.faceCount);
-                for (uint32_t f = 0; f < mesh.faceCount; ++f)
+                for (size_t f = 0; f < indices.size() / 3; ++f)
                 {
-                    auto a = reader.readUInt32();
-                    auto b = reader.readUInt32();
-                    auto c = reader.readUInt32();
-
-                    mesh.faceInfo.cornerIndex[f].index[0] = a;
-                    mesh.faceInfo.cornerIndex[f].index[1] = b;
-                    mesh.faceInfo.cornerIndex[f].index[2] = c;
+                    mesh.faceInfo.cornerIndex[f].index[0] = indices[f * 3 + 0];
+                    mesh.faceInfo.cornerIndex[f].index[1] = indices[f * 3 + 1];
+                    mesh.faceInfo.cornerIndex[f].index[2] = indices[f * 3 + 2];
                 }
             }
             else if (chunkId == "RPOS")
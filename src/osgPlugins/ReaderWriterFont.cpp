@@ -7,6 +7,7 @@
 #include <osgDB/FileUtils>
 #include <osgDB/ReadFile>
 #include "IFileSys.hpp"
+#include "osg/TextureCache.hpp"
 #include "ui/ImageFont.hpp"
 
 namespace ehb
@@ -63,12 +64,12 @@ namespace ehb
                     const int height = node->valueAsInt("height");
                     const std::string textureFileName = node->valueOf("texture");
 
-                    if (auto image = osgDB::readRefImageFile(textureFileName + ".raw"))
+                    if (auto image = TextureCache::instance().image(textureFileName + ".raw"))
                     {
                         const float imageWidth = image->s();
                         const float imageHeight = image->t();
 
-                        osg::ref_ptr<ImageFont> font = new ImageFont(new osg::Texture2D(image), height);
+                        osg::ref_ptr<ImageFont> font = new ImageFont(TextureCache::instance().texture(image.get(), TextureCache::Wrap::Clamp), height);
 
                         font->setName(textureFileName);
 
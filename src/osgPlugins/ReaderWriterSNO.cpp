@@ -2,6 +2,7 @@
 #include "ReaderWriterSNO.hpp"
 
 #include "osg/SiegeNodeMesh.hpp"
+#include "osg/TextureCache.hpp"
 
 #include <osg/Texture2D>
 #include <osgDB/FileNameUtils>
@@ -14,10 +15,158 @@
 #include <osg/MatrixTransform>
 #include <osg/Notify>
 #include <osg/Matrix>
+#include <osg/Timer>
+#include <osg/BufferObject>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
 
 namespace ehb
 {
-    ReaderWriterSNO::ReaderWriterSNO(IFileSys& fileSys) : fileSys(fileSys)
+    namespace
+    {
+        //! a corner as it is stored in the file, the color is read as one value so it comes out right on any cpu
+        struct Corner
+        {
+            osg::Vec3 position;
+            osg::Vec3 normal;
+            uint32_t color; //!< bytes are r, b, g, a
+            osg::Vec2 uv;
+        };
+
+        static_assert(sizeof(Corner) == 36, "corners are 36 bytes in the file");
+
+        //! osg has no half float array, an unsigned short array is the same size and is only handed to gl as half floats
+        class Vec2hArray final : public osg::Vec2usArray
+        {
+        public:
+
+            explicit Vec2hArray(unsigned int count) : osg::Vec2usArray(count)
+            {
+                _dataType = GL_HALF_FLOAT;
+            }
+
+            Vec2hArray(const Vec2hArray& array, const osg::CopyOp& copyop) : osg::Vec2usArray(array, copyop)
+            {
+            }
+
+            // copies have to stay half floats, the region batching pass builds its arrays from cloneType
+            virtual osg::Object* cloneType() const override { return new Vec2hArray(0); }
+            virtual osg::Object* clone(const osg::CopyOp& copyop) const override { return new Vec2hArray(*this, copyop); }
+        };
+
+        //! round to the nearest half float, anything too large becomes infinity and anything too small becomes zero
+        uint16_t toHalf(float value)
+        {
+            uint32_t bits; std::memcpy(&bits, &value, sizeof(bits));
+
+            const uint32_t sign = (bits >> 16) & 0x8000;
+            const uint32_t biased = (bits >> 23) & 0xff;
+            const int32_t exponent = static_cast<int32_t>(biased) - 127 + 15;
+
+            uint32_t mantissa = bits & 0x7fffff;
+
+            // infinity stays infinity and a nan stays a nan
+            if (biased == 0xff) return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+            if (exponent >= 31) return static_cast<uint16_t>(sign | 0x7c00);
+
+            // too small for a normal half so it's stored as a denormal with the implicit leading bit shifted in
+            if (exponent <= 0)
+            {
+                if (exponent < -10) return static_cast<uint16_t>(sign);
+
+                mantissa |= 0x800000;
+
+                const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+                const uint32_t remainder = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+
+                uint32_t half = mantissa >> shift;
+
+                if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) half++;
+
+                return static_cast<uint16_t>(sign | half);
+            }
+
+            uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+
+            // rounding up can carry into the exponent which is still the right answer
+            const uint32_t remainder = mantissa & 0x1fff;
+
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) half++;
+
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        //! normals fit in shorts that gl scales back to -1 to 1
+        osg::Vec3s toShortNormal(const osg::Vec3& normal)
+        {
+            const auto pack = [](float value) { return static_cast<short>(std::lround(osg::clampBetween(value, -1.0f, 1.0f) * 32767.0f)); };
+
+            return osg::Vec3s(pack(normal.x()), pack(normal.y()), pack(normal.z()));
+        }
+
+        //! adds count ids to the end of indices, count is cut down to what is left in the file
+        uint32_t readIndices(BinaryReader& reader, std::vector<uint16_t>& indices, uint32_t& count)
+        {
+            const size_t first = indices.size();
+
+            count = static_cast<uint32_t>(std::min<size_t>(count, reader.remaining() / sizeof(uint16_t)));
+
+            indices.resize(first + count);
+            reader.readArray(indices.data() + first, count);
+
+            return static_cast<uint32_t>(first);
+        }
+
+        /*
+         * makes sure every face of the logical node can be found through its box tree. the boxes are grown to hold their
+         * own faces and their children, walking back to front so children are done before the box holding them
+         *
+         * @return false if the tree points outside of the faces or leaves some of them out
+         */
+        bool finishBoxTree(SiegeNodeMesh::LogicalNodeGrouping& grouping)
+        {
+            std::vector<SiegeNodeMesh::BoxTreeNode>& boxTree = grouping.boxTree;
+            std::vector<bool> covered(grouping.logicalNodeFaces.size(), false);
+
+            for (size_t i = boxTree.size(); i-- > 0;)
+            {
+                SiegeNodeMesh::BoxTreeNode& box = boxTree[i];
+
+                for (uint32_t j = 0; j < box.faceCount; ++j)
+                {
+                    const uint16_t index = grouping.indices[box.firstFace + j];
+
+                    if (index >= covered.size()) return false;
+
+                    covered[index] = true;
+
+                    const SiegeNodeMesh::Face& face = grouping.logicalNodeFaces[index];
+
+                    for (const osg::Vec3& corner : { face.a, face.b, face.c })
+                    {
+                        box.bbox.expandBy(corner);
+                    }
+                }
+
+                for (size_t child = i + 1; child < box.skip; child = boxTree[child].skip)
+                {
+                    box.bbox.expandBy(boxTree[child].bbox);
+                }
+            }
+
+            return std::find(covered.begin(), covered.end(), false) == covered.end();
+        }
+    }
+
+    template <> struct FieldSize<Corner> : std::integral_constant<size_t, sizeof(uint32_t)> {};
+
+    ReaderWriterSNO::ReaderWriterSNO(IFileSys& fileSys, bool compactVertices) : fileSys(fileSys), compactVertices(compactVertices)
     {
         supportsExtension("sno", "Dungeon Siege SNO Mesh");
 
@@ -47,7 +196,13 @@ namespace ehb
         InputStream stream = fileSys.createInputStream(fileName);
         if (!stream) return ReadResult::FILE_NOT_HANDLED;
 
-        return readNode(*stream, options);
+        osg::Timer timer;
+
+        ReadResult result = readNode(*stream, options);
+
+        log->debug("{} parsed in {:.3f}ms", fileName, timer.time_m());
+
+        return result;
     }
 
     osgDB::ReaderWriter::ReadResult ReaderWriterSNO::readNode(std::istream& stream, const osgDB::Options* options) const
@@ -104,6 +259,9 @@ namespace ehb
             reader.skipBytes(count * 4);
         }
 
+        // sorted so placing a region can look doors up by id without scanning them
+        std::stable_sort(node->doorXform.begin(), node->doorXform.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
         for (uint32_t index = 0; index < spotCount; index++)
         {
             // rot, pos, string?
@@ -113,25 +271,82 @@ namespace ehb
 
         // create vertex data per entire mesh
         osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(cornerCount);
-        osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(cornerCount);
-        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array(cornerCount);
-        osg::ref_ptr<osg::Vec2Array> tcoords = new osg::Vec2Array(cornerCount);
+        osg::ref_ptr<osg::Vec4ubArray> colors = new osg::Vec4ubArray(cornerCount);
+
+        // the compact layout keeps normals in shorts and texture coordinates in half floats, 26 bytes a corner instead of 36
+        osg::ref_ptr<osg::Vec3Array> floatNormals;
+        osg::ref_ptr<osg::Vec2Array> floatTexCoords;
+        osg::ref_ptr<osg::Vec3sArray> shortNormals;
+        osg::ref_ptr<Vec2hArray> halfTexCoords;
+        osg::Array* normals;
+        osg::Array* tcoords;
+
+        if (compactVertices)
+        {
+            shortNormals = new osg::Vec3sArray(cornerCount);
+            halfTexCoords = new Vec2hArray(cornerCount);
+
+            shortNormals->setNormalize(true);
 
-        for (uint32_t index = 0; index < cornerCount; index++)
+            normals = shortNormals.get();
+            tcoords = halfTexCoords.get();
+        }
+        else
         {
-            (*vertices)[index] = reader.readVec3();
-            (*normals)[index] = reader.readVec3();
+            floatNormals = new osg::Vec3Array(cornerCount);
+            floatTexCoords = new osg::Vec2Array(cornerCount);
+
+            normals = floatNormals.get();
+            tcoords = floatTexCoords.get();
+        }
+
+        // colors stay the 4 bytes they are on disk and gl scales them to 0-1, the float colors this used to build held 0-255
+        colors->setNormalize(true);
+
+        // the whole corner block is read at once and split out into the separate arrays in a single pass over it
+        std::vector<Corner> cornerScratch;
+        const Span<Corner> corners = reader.readSpan(cornerCount, cornerScratch);
+
+        for (size_t index = 0; index < corners.size(); index++)
+        {
+            const Corner& corner = corners[index];
+
+            (*vertices)[index] = corner.position;
 
             // colors are swizzled - unswizzle the swizzle
-            auto r = reader.readUInt8(); auto b = reader.readUInt8(); auto g = reader.readUInt8(); auto a = reader.readUInt8();
-            (*colors)[index] = osg::Vec4(r, g, b, a);
+            const uint32_t color = corner.color;
+            (*colors)[index].set(color & 0xff, (color >> 16) & 0xff, (color >> 8) & 0xff, color >> 24);
+
+            // should we just flip the v coordinate when it gets loaded in the by the reader?
+            if (compactVertices)
+            {
+                (*shortNormals)[index] = toShortNormal(corner.normal);
+                (*halfTexCoords)[index].set(toHalf(corner.uv.x()), toHalf(1 - corner.uv.y()));
+            }
+            else
+            {
+                (*floatNormals)[index] = corner.normal;
+                (*floatTexCoords)[index].set(corner.uv.x(), 1 - corner.uv.y());
+            }
+        }
 
-            (*tcoords)[index] = reader.readVec2();
+        // every texture section of a compact mesh draws out of one vertex buffer and one index buffer
+        osg::ref_ptr<osg::ElementBufferObject> elementBuffer;
 
-            // should we just flip this when it gets loaded in the by the reader?
-            (*tcoords)[index][1] = 1 - (*tcoords)[index][1];
+        if (compactVertices)
+        {
+            osg::ref_ptr<osg::VertexBufferObject> vertexBuffer = new osg::VertexBufferObject;
+
+            for (osg::Array* array : { static_cast<osg::Array*>(vertices.get()), normals, static_cast<osg::Array*>(colors.get()), tcoords })
+            {
+                array->setVertexBufferObject(vertexBuffer);
+            }
+
+            elementBuffer = new osg::ElementBufferObject;
         }
 
+        std::vector<uint16_t> indexScratch, pairScratch;
+
         for (uint32_t index = 0; index < textureCount; index++)
         {
             std::string textureFileName = reader.readString();
@@ -140,12 +355,12 @@ namespace ehb
             // create our unsigned short index data, as per the mesh format
             osg::ref_ptr<osg::DrawElementsUShort> elements = new osg::DrawElementsUShort(GL_TRIANGLES, static_cast<uint32_t>(count));
 
-            // read in each index value and adjust for the global vertex list
-            for (uint32_t j = 0; j < count; ++j)
-            {
-                uint16_t value = reader.readUInt16();
+            // read in the index values and adjust for the global vertex list
+            const Span<uint16_t> indices = reader.readSpan(count, indexScratch);
 
-                (*elements)[j] = start + value;
+            for (uint32_t j = 0; j < indices.size(); ++j)
+            {
+                (*elements)[j] = start + indices[j];
             }
 
             osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
@@ -189,25 +404,35 @@ namespace ehb
             {
                 // log->warn("{}.gas not found falling back to {}.raw", textureFileName, textureFileName);
 
-                if (osg::ref_ptr<osg::Image> image = osgDB::readImageFile(textureFileName + ".raw"))
-                {
-                    osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
-
-                    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-                    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
+                // every node using this texture shares the one state set so they can be drawn without any state changes between them
+                stateSet = TextureCache::instance().stateSet(textureFileName + ".raw", TextureCache::Wrap::Repeat);
+            }
 
-                    geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
-                }
+            if (stateSet != nullptr)
+            {
+                geometry->setStateSet(stateSet);
             }
 
             // set our geometry pointers
             geometry->setVertexArray(vertices.get());
             geometry->setColorArray(colors.get());
-            geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+            geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+
+            geometry->setTexCoordArray(0, tcoords);
+
+            if (compactVertices)
+            {
+                // only unit 0 ever has a texture so the second copy of the coordinates is left off
+                elements->setElementBufferObject(elementBuffer);
 
-            // most nodes have 2 layers so we will map 2 units for now
-            geometry->setTexCoordArray(0, tcoords.get());
-            geometry->setTexCoordArray(1, tcoords.get());
+                geometry->setUseDisplayList(false);
+                geometry->setUseVertexBufferObjects(true);
+            }
+            else
+            {
+                // most nodes have 2 layers so we will map 2 units for now
+                geometry->setTexCoordArray(1, tcoords);
+            }
 
             // add index data to the geometry
             geometry->addPrimitiveSet(elements.get());
@@ -229,67 +454,101 @@ namespace ehb
 
             logicalNodeGrouping.flag = (SiegeNodeMesh::FloorFlag)reader.readUInt32();
 
-            // no idea what this is yet
-            uint32_t unkCount1 = reader.readUInt32();
-            for (uint32_t j = 0; j < unkCount1; ++j)
+            // the leaves the logical node is split into, the 9 floats look to be the box of the leaf and then its center
+            const uint32_t leafCount = reader.readUInt32();
+            for (uint32_t j = 0; j < leafCount && reader.remaining() != 0; ++j)
             {
-                uint16_t index = reader.readUInt16();
+                SiegeNodeMesh::Leaf& leaf = logicalNodeGrouping.leaves.emplace_back();
 
-                float unkRotation[9]; reader.readBytes(&unkRotation, sizeof(float) * 9);
+                leaf.id = reader.readUInt16();
+                leaf.bbox._min = reader.readVec3();
+                leaf.bbox._max = reader.readVec3();
+                leaf.center = reader.readVec3();
 
-                uint16_t unkShortArrayCount1 = reader.readUInt16();
-                reader.skipBytes(sizeof(uint16_t) * unkShortArrayCount1);
+                leaf.neighbourCount = reader.readUInt16();
+                leaf.firstNeighbour = readIndices(reader, logicalNodeGrouping.indices, leaf.neighbourCount);
 
-                uint32_t unkShortArrayCount2 = reader.readUInt32();
-                reader.skipBytes(sizeof(uint16_t) * unkShortArrayCount2);
+                leaf.faceCount = reader.readUInt32();
+                leaf.firstFace = readIndices(reader, logicalNodeGrouping.indices, leaf.faceCount);
             }
 
-            uint32_t unkShortPairSectionCount = reader.readUInt32();
-            for (uint32_t j = 0; j < unkShortPairSectionCount; ++j)
+            // which leaves of this logical node touch which leaves of another one
+            const uint32_t connectionCount = reader.readUInt32();
+            for (uint32_t j = 0; j < connectionCount && reader.remaining() != 0; ++j)
             {
-                uint8_t unkByte = reader.readUInt8();
+                const uint8_t farId = reader.readUInt8();
+                const uint32_t pairCount = reader.readUInt32();
 
-                uint32_t unkCount2 = reader.readUInt32();
+                const Span<uint16_t> pairs = reader.readSpan(static_cast<size_t>(pairCount) * 2, pairScratch);
 
-                reader.skipBytes((sizeof(uint16_t) * unkCount2) * 2);
+                for (size_t k = 0; k + 1 < pairs.size(); k += 2)
+                {
+                    logicalNodeGrouping.leafConnections.push_back(SiegeNodeMesh::LeafConnection{ farId, pairs[k], pairs[k + 1] });
+                }
             }
 
             uint32_t triangleCount = reader.readUInt32();
-            logicalNodeGrouping.logicalNodeFaces.resize(triangleCount);
-            for (uint32_t j = 0; j < triangleCount; ++j)
+
+            // each face is its 3 corners followed by its normal
+            std::vector<osg::Vec3> faceScratch;
+            const Span<osg::Vec3> faceData = reader.readSpan(static_cast<size_t>(triangleCount) * 4, faceScratch);
+
+            logicalNodeGrouping.logicalNodeFaces.resize(faceData.size() / 4);
+            for (size_t j = 0; j < logicalNodeGrouping.logicalNodeFaces.size(); ++j)
             {
-                SiegeNodeMesh::Face& face = logicalNodeGrouping.logicalNodeFaces.at(j);
-                face.a = reader.readVec3();
-                face.b = reader.readVec3();
-                face.c = reader.readVec3();
+                SiegeNodeMesh::Face& face = logicalNodeGrouping.logicalNodeFaces[j];
+                face.a = faceData[j * 4 + 0];
+                face.b = faceData[j * 4 + 1];
+                face.c = faceData[j * 4 + 2];
 
-                face.normal = reader.readVec3();
+                face.normal = faceData[j * 4 + 3];
             }
 
-            recurse_unknown_section(reader);
+            for (const SiegeNodeMesh::Face& face : logicalNodeGrouping.logicalNodeFaces)
+            {
+                for (const osg::Vec3& corner : { face.a, face.b, face.c })
+                {
+                    logicalNodeGrouping.bbox.expandBy(corner);
+                }
+            }
+
+            node->logicalBounds.expandBy(logicalNodeGrouping.bbox);
+
+            readBoxTree(reader, logicalNodeGrouping);
+
+            if (!finishBoxTree(logicalNodeGrouping))
+            {
+                log->debug("logical node {} has a box tree that doesn't cover its {} faces, they will be tested one by one", logicalNodeGrouping.id, logicalNodeGrouping.logicalNodeFaces.size());
+
+                logicalNodeGrouping.boxTree.clear();
+            }
         }
 
         return node.release();
     }
 
-    void ReaderWriterSNO::recurse_unknown_section(BinaryReader& reader) const
+    void ReaderWriterSNO::readBoxTree(BinaryReader& reader, SiegeNodeMesh::LogicalNodeGrouping& grouping) const
     {
-        float unkbBox[6]; reader.readBytes(unkbBox, sizeof(float) * 6);
+        // the tree is read as it is listed, every box is followed by the boxes inside of it
+        const size_t index = grouping.boxTree.size();
 
-        uint8_t unkByte1 = reader.readUInt8();
+        SiegeNodeMesh::BoxTreeNode& box = grouping.boxTree.emplace_back();
 
-        uint16_t unkCount3 = reader.readUInt16();
-        std::vector<uint16_t> unkArrayOfShorts;
-        for (uint32_t i = 0; i < unkCount3; i++)
-        {
-            uint16_t value = reader.readUInt16();
-            unkArrayOfShorts.push_back(value);
-        }
+        box.bbox._min = reader.readVec3();
+        box.bbox._max = reader.readVec3();
 
-        uint8_t unkByte2 = reader.readUInt8();
-        for (uint8_t i = 0; i < unkByte2; i++)
+        // set on boxes without children as far as can be told
+        const uint8_t unkByte1 = reader.readUInt8();
+
+        box.faceCount = reader.readUInt16();
+        box.firstFace = readIndices(reader, grouping.indices, box.faceCount);
+
+        const uint8_t childCount = reader.readUInt8();
+        for (uint8_t i = 0; i < childCount && reader.remaining() != 0; i++)
         {
-            recurse_unknown_section(reader);
+            readBoxTree(reader, grouping);
         }
+
+        grouping.boxTree[index].skip = static_cast<uint32_t>(grouping.boxTree.size());
     }
 }
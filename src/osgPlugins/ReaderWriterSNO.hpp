@@ -13,6 +13,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include "osg/SiegeNodeMesh.hpp"
+
 namespace ehb
 {
     class IFileSys;
@@ -21,7 +23,8 @@ namespace ehb
     {
     public:
 
-        ReaderWriterSNO(IFileSys & fileSys);
+        //! @param compactVertices store normals as shorts and texture coordinates as half floats in one vertex buffer per mesh
+        ReaderWriterSNO(IFileSys & fileSys, bool compactVertices = false);
 
         virtual ~ReaderWriterSNO() = default;
 
@@ -37,9 +40,12 @@ namespace ehb
 
         IFileSys & fileSys;
 
+        bool compactVertices;
+
         std::shared_ptr<spdlog::logger> log;
 
-        void recurse_unknown_section(BinaryReader& reader) const;
+        //! reads a logical node's box tree into it, the boxes come out in the order SiegeNodeMesh::BoxTreeNode expects
+        void readBoxTree(BinaryReader& reader, SiegeNodeMesh::LogicalNodeGrouping& grouping) const;
     };
 
     // https://github.com/xarray/osgRecipes/blob/master/cookbook/chapter8/ch08_07/OctreeBuilder.cpp
@@ -5,15 +5,21 @@
 #include "gas/Fuel.hpp"
 
 #include "osg/SiegeNodeMesh.hpp"
+#include "osg/TextureCache.hpp"
 #include "world/Region.hpp"
+#include "Parallel.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <unordered_set>
 #include <osg/MatrixTransform>
+#include <osg/Timer>
 #include <osgDB/ReadFile>
 #include <osgDB/FileUtils>
 
 namespace ehb
 {
-    ReaderWriterSiegeNodeList::ReaderWriterSiegeNodeList(IFileSys& fileSys) : fileSys(fileSys)
+    ReaderWriterSiegeNodeList::ReaderWriterSiegeNodeList(IFileSys& fileSys, bool batchRegions) : fileSys(fileSys), batchRegions(batchRegions)
     {
         log = spdlog::get("log");
 
@@ -71,18 +77,77 @@ namespace ehb
         return readNode(*stream, options);
     }
 
-    osgDB::ReaderWriter::ReadResult ReaderWriterSiegeNodeList::readNode(std::istream& stream, const osgDB::Options* options) const
+    osg::ref_ptr<SiegeNodeMesh> ReaderWriterSiegeNodeList::loadMesh(const std::string& meshFileName, const std::string& texSetAbbr, const osgDB::Options* options, bool& cached) const
+    {
+        const std::string key = meshFileName + ':' + texSetAbbr;
+
+        osg::ref_ptr<SiegeNodeMesh> mesh;
+
+        {
+            std::lock_guard<std::mutex> lock(meshCacheMutex);
+
+            if (const auto itr = meshCache.find(key); itr != meshCache.end() && itr->second.lock(mesh))
+            {
+                cached = true;
+
+                return mesh;
+            }
+        }
+
+        // reading happens outside of the lock so regions paging in on other threads aren't held up behind it
+        osg::ref_ptr<osgDB::ReaderWriter::Options> localOptions = options ? options->cloneOptions() : new osgDB::ReaderWriter::Options;
+        localOptions->setOptionString("texsetabbr=" + texSetAbbr);
+
+        mesh = dynamic_cast<SiegeNodeMesh*>(osgDB::readRefNodeFile(meshFileName + ".sno", localOptions.get()).get());
+
+        if (mesh == nullptr) return nullptr;
+
+        if (batchRegions) Region::prepareForBatching(*mesh);
+
+        std::lock_guard<std::mutex> lock(meshCacheMutex);
+
+        // if another thread finished reading the same mesh first use its copy so there is still only one
+        osg::observer_ptr<SiegeNodeMesh>& entry = meshCache[key];
+
+        if (osg::ref_ptr<SiegeNodeMesh> existing; entry.lock(existing))
+        {
+            cached = true;
+
+            return existing;
+        }
+
+        entry = mesh;
+        cached = false;
+
+        return mesh;
+    }
+
+    void ReaderWriterSiegeNodeList::pruneMeshCache() const
     {
-        // struct to hold each entry defined in [door*]
-        struct DoorEntry
+        std::lock_guard<std::mutex> lock(meshCacheMutex);
+
+        for (auto itr = meshCache.begin(); itr != meshCache.end();)
         {
-            uint32_t id;
-            uint32_t farDoor;
-            uint64_t farGuid;
-        };
+            if (itr->second.valid())
+            {
+                ++itr;
+            }
+            else
+            {
+                itr = meshCache.erase(itr);
+            }
+        }
+    }
+
+    osgDB::ReaderWriter::ReadResult ReaderWriterSiegeNodeList::readNode(std::istream& stream, const osgDB::Options* options) const
+    {
+        // the regions that were unloaded since the last one was read leave their meshes behind as empty observers
+        pruneMeshCache();
 
-        std::unordered_multimap<uint32_t, DoorEntry> doorMap;
-        std::set<uint32_t> completeSet;
+        // every mesh this region uses once, any node beyond the first to use a mesh is an instance of it
+        std::unordered_set<const SiegeNodeMesh*> regionMeshes;
+        size_t sharedMeshCount = 0, instancedBytes = 0;
+        SiegeNodeMesh::Footprint regionFootprint;
 
         if (Fuel doc; doc.load(stream))
         {
@@ -100,6 +165,29 @@ namespace ehb
             const uint32_t targetnode = doc.valueAsUInt("siege_node_list:targetnode");
             regionGroup->setUserValue<uint32_t>("targetnode", targetnode);
 
+            // nodes are gathered first so every mesh the region needs can be read at once, the region is then built in file order
+            struct NodeEntry
+            {
+                const FuelBlock* node;
+                uint32_t guid;
+                std::string meshGuid;
+                std::string meshFileName;
+                size_t load; //!< index into meshLoads or npos when the mesh guid isn't known
+            };
+
+            struct MeshLoad
+            {
+                std::string meshFileName;
+                std::string texSetAbbr;
+                osg::ref_ptr<SiegeNodeMesh> mesh;
+                bool cached = false;
+                double loadTime = 0; //!< milliseconds
+            };
+
+            std::vector<NodeEntry> nodeEntries;
+            std::vector<MeshLoad> meshLoads;
+            std::unordered_map<std::string, size_t> meshLoadIndex;
+
             for (const auto node : doc.eachChildOf("siege_node_list"))
             {
                 const uint32_t nodeGuid = node->valueAsUInt("guid");
@@ -111,23 +199,111 @@ namespace ehb
                 // handle all [door*] entrires
                 for (const auto doorEntry : node->eachChild())
                 {
-                    DoorEntry e;
+                    Region::DoorLink link;
+
+                    link.guid = nodeGuid;
+                    link.door = doorEntry->valueAsUInt("id");
+                    link.farGuid = static_cast<uint32_t>(std::stoul(doorEntry->valueOf("farguid"), nullptr, 16));
+                    link.farDoor = doorEntry->valueAsUInt("fardoor");
+
+                    regionGroup->addDoorLink(link);
+                }
+
+                NodeEntry& entry = nodeEntries.emplace_back(NodeEntry{ node, nodeGuid, meshGuid, resolveFileName(meshGuid), std::string::npos });
+
+                if (entry.meshFileName != meshGuid)
+                {
+                    const auto itr = meshLoadIndex.emplace(entry.meshFileName + ':' + texSetAbbr, meshLoads.size());
+
+                    if (itr.second)
+                    {
+                        meshLoads.push_back(MeshLoad{ entry.meshFileName, texSetAbbr });
+                    }
+
+                    entry.load = itr.first->second;
+                }
+            }
+
+            // meshes only depend on their own files so they are read in parallel, the filesystem, the naming key map, the
+            // texture cache and the mesh cache are all safe to use from any thread
+            unsigned int threadCount = 0;
+
+            if (options != nullptr)
+            {
+                // anything that isn't a plain number is ignored and the default is used
+                const std::string value = options->getPluginStringData("threadcount");
+
+                const char* end = value.data() + value.size();
+
+                if (const auto result = std::from_chars(value.data(), end, threadCount); result.ec != std::errc() || result.ptr != end)
+                {
+                    threadCount = 0;
+                }
+            }
+
+            if (threadCount == 0) threadCount = defaultThreadCount();
+
+            osg::Timer timer;
+
+            parallelFor(meshLoads.size(), [this, &meshLoads, options](size_t i)
+                {
+                    MeshLoad& load = meshLoads[i];
+
+                    osg::Timer loadTimer;
 
-                    e.id = doorEntry->valueAsUInt("id");
-                    e.farDoor = doorEntry->valueAsUInt("fardoor");
-                    e.farGuid = std::stoul(doorEntry->valueOf("farguid"), nullptr, 16);
+                    load.mesh = loadMesh(load.meshFileName, load.texSetAbbr, options, load.cached);
+                    load.loadTime = loadTimer.time_m();
+                }, threadCount);
 
-                    doorMap.emplace(nodeGuid, std::move(e));
+            const double readTime = timer.time_m();
+
+            // the slowest meshes read from scratch are where any parser work should be looking first
+            std::vector<const MeshLoad*> slowest;
+            double loadTime = 0;
+
+            for (const MeshLoad& load : meshLoads)
+            {
+                if (load.mesh != nullptr && !load.cached)
+                {
+                    slowest.push_back(&load);
+                    loadTime += load.loadTime;
                 }
+            }
+
+            const size_t slowestCount = std::min<size_t>(slowest.size(), 5);
+
+            std::partial_sort(slowest.begin(), slowest.begin() + slowestCount, slowest.end(), [](const MeshLoad* lhs, const MeshLoad* rhs) { return lhs->loadTime > rhs->loadTime; });
+
+            for (size_t i = 0; i < slowestCount; ++i)
+            {
+                log->info("slow mesh: {} ({} KiB of geometry) took {:.3f}ms", slowest[i]->meshFileName, slowest[i]->mesh->geometryBytes() / 1024, slowest[i]->loadTime);
+            }
 
-                if (const std::string meshFileName = resolveFileName(meshGuid); meshFileName != meshGuid)
+            log->info("read {} meshes in {:.3f}ms on {} threads, {} were read from scratch taking {:.3f}ms across all threads ({:.3f}ms each)",
+                meshLoads.size(), readTime, threadCount, slowest.size(), loadTime, slowest.empty() ? 0.0 : loadTime / slowest.size());
+
+            for (const NodeEntry& entry : nodeEntries)
+            {
+                const FuelBlock* node = entry.node;
+
+                if (entry.load != std::string::npos)
                 {
-                    osg::ref_ptr<osgDB::ReaderWriter::Options> localOptions = options ? options->cloneOptions() : new osgDB::ReaderWriter::Options;
-                    localOptions->setOptionString("texsetabbr=" + texSetAbbr);
+                    const MeshLoad& load = meshLoads[entry.load];
 
-                    if (auto mesh = dynamic_cast<SiegeNodeMesh*>(osgDB::readNodeFile(meshFileName + ".sno", localOptions.get())))
+                    if (SiegeNodeMesh* mesh = load.mesh.get())
                     {
-                        // log->debug("handling mesh: {}", meshFileName);
+                        if (regionMeshes.emplace(mesh).second)
+                        {
+                            regionFootprint += mesh->footprint();
+
+                            if (load.cached) sharedMeshCount++;
+                        }
+                        else
+                        {
+                            instancedBytes += mesh->geometryBytes();
+                        }
+
+                        // log->debug("handling mesh: {}", entry.meshFileName);
 
                         osg::ref_ptr<osg::MatrixTransform> xform = new osg::MatrixTransform;
 
@@ -140,50 +316,43 @@ namespace ehb
                         xform->setUserValue("occludes_camera", node->valueAsBool("occludes_camera"));
                         xform->setUserValue("occludes_light", node->valueAsBool("occludes_light"));
 
-                        regionGroup->addChild(xform);
                         xform->addChild(mesh);
 
-                        regionGroup->nodeMap.emplace(nodeGuid, xform);
+                        regionGroup->addNode(entry.guid, xform);
                     }
                     else
                     {
-                        log->error("couldn't find mesh guid {} ({})", meshGuid, meshFileName);
+                        log->error("couldn't find mesh guid {} ({})", entry.meshGuid, entry.meshFileName);
                     }
                 }
                 else
                 {
-                    log->error("mesh guid {} is not listed in {}", meshGuid, "/world/global/siege_nodes");
+                    log->error("mesh guid {} is not listed in {}", entry.meshGuid, "/world/global/siege_nodes");
                 }
             }
 
+            // doors leading to nodes that couldn't be placed don't lead anywhere
+            const auto unplaced = [&regionGroup](const Region::DoorLink& link)
+            {
+                return regionGroup->nodeMap.count(link.guid) == 0 || regionGroup->nodeMap.count(link.farGuid) == 0;
+            };
+
+            regionGroup->doorLinks.erase(std::remove_if(regionGroup->doorLinks.begin(), regionGroup->doorLinks.end(), unplaced), regionGroup->doorLinks.end());
+
             // easy access to targetGuid later on. though this is only valid when the region is initially loaded. not sure if
             // it will remain valid in future frames (pathfinding?)
             regionGroup->setUserValue("targetnode", targetnode);
 
-            // recursive function to place every node in the region
-            std::function<void(const uint32_t)> func = [&func, &doorMap, &regionGroup, &completeSet](const uint32_t guid)
-            {
-                if (completeSet.insert(guid).second)
-                {
-                    osg::ref_ptr<osg::MatrixTransform> targetNode = regionGroup->nodeMap.at(guid);
-
-                    const auto range = doorMap.equal_range(guid);
-
-                    for (auto entry = range.first; entry != range.second; ++entry)
-                    {
-                        osg::ref_ptr<osg::MatrixTransform> connectNode = regionGroup->nodeMap.at(entry->second.farGuid);
+            timer.setStartTick();
 
-                        SiegeNodeMesh::connect(targetNode, entry->second.id, connectNode, entry->second.farDoor);
+            const Region::PlacementStats placement = regionGroup->placeNodes(targetnode);
 
-                        if (completeSet.count(entry->second.farGuid) == 0)
-                        {
-                            func(entry->second.farGuid);
-                        }
-                    }
-                }
-            };
+            log->info("placed {} of {} nodes through {} doors in {:.3f}ms", placement.placed, regionGroup->nodeMap.size(), placement.connections, timer.time_m());
 
-            func(targetnode);
+            if (placement.missingDoors != 0)
+            {
+                log->error("{} doors couldn't be connected since their mesh doesn't have them", placement.missingDoors);
+            }
 
             // index 8 of the user data container will contain our target node xform for now
             if (osg::MatrixTransform* targetNodeXform = regionGroup->nodeMap.at(targetnode))
@@ -197,8 +366,31 @@ namespace ehb
                 return osgDB::ReaderWriter::ReadResult::ERROR_IN_READING_FILE;
             }
 
+            regionGroup->buildSurfaceIndex();
+
+            log->debug("region surface index has {} nodes over a {}x{} grid", regionGroup->surfaceNodes.size(), regionGroup->gridColumns, regionGroup->gridRows);
+
+            if (batchRegions)
+            {
+                const Region::BatchStats batchStats = regionGroup->buildDrawBatches();
+
+                log->info("region draws {} node drawables in {} batches holding {} KiB of vertices and {} KiB of indices",
+                    batchStats.drawables, batchStats.batches, batchStats.vertexBytes / 1024, batchStats.indexBytes / 1024);
+            }
+
             log->debug("region loaded with {} nodes, targetGuid: 0x{:x}", regionGroup->getNumChildren(), targetnode);
 
+            log->info("region has {} nodes using {} unique meshes ({} already loaded by another region) and {} instanced nodes, {} KiB of mesh data with {} KiB saved by instancing",
+                regionGroup->nodeMap.size(), regionMeshes.size(), sharedMeshCount, regionGroup->nodeMap.size() - regionMeshes.size(), regionFootprint.total() / 1024, instancedBytes / 1024);
+
+            log->info("region mesh data is {} KiB of vertices, {} KiB of indices and {} KiB of logical node faces",
+                regionFootprint.vertexBytes / 1024, regionFootprint.indexBytes / 1024, regionFootprint.faceBytes / 1024);
+
+            const TextureCache::Stats textureStats = TextureCache::instance().stats();
+
+            log->info("texture cache now holds {} images ({} KiB) shared by {} textures, {} of {} requests shared, {} uploads so far",
+                textureStats.images, textureStats.imageBytes / 1024, textureStats.textures, textureStats.hits, textureStats.requests, textureStats.uploads);
+
             return regionGroup.release();
         }
 
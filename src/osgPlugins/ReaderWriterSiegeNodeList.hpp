@@ -1,7 +1,10 @@
 
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
 #include <vector>
+#include <osg/observer_ptr>
 #include <osgDB/ReaderWriter>
 
 #include <spdlog/spdlog.h>
@@ -9,11 +12,13 @@
 namespace ehb
 {
     class IFileSys;
+    class SiegeNodeMesh;
     class ReaderWriterSiegeNodeList : public osgDB::ReaderWriter
     {
     public:
 
-        ReaderWriterSiegeNodeList(IFileSys& fileSys);
+        //! @param batchRegions merge the node geometry of each region into one draw per texture, see Region::buildDrawBatches
+        ReaderWriterSiegeNodeList(IFileSys& fileSys, bool batchRegions = false);
 
         virtual ~ReaderWriterSiegeNodeList() = default;
 
@@ -29,13 +34,30 @@ namespace ehb
 
         const std::string& resolveFileName(const std::string& filename) const;
 
+        /*
+         * a mesh is only ever read once for each texture set while something still holds on to it, every node using it
+         * shares the same geometry and state under its own transform
+         *
+         * @param cached set when the mesh was already loaded, either earlier in this region or by another region
+         */
+        osg::ref_ptr<SiegeNodeMesh> loadMesh(const std::string& meshFileName, const std::string& texSetAbbr, const osgDB::Options* options, bool& cached) const;
+
+        //! drop the entries of every mesh no region holds on to anymore
+        void pruneMeshCache() const;
+
     private:
 
         IFileSys& fileSys;
 
+        bool batchRegions;
+
         // guid=0xa2010103, filename=t_cry01_cave-1c;
         std::unordered_map<std::string, std::string> meshFileNameToGuidKeyMap;
 
+        //! keyed by mesh file name and texture set, observers so a mesh goes away once the last region using it does, see pruneMeshCache
+        mutable std::unordered_map<std::string, osg::observer_ptr<SiegeNodeMesh>> meshCache;
+        mutable std::mutex meshCacheMutex;
+
         std::shared_ptr<spdlog::logger> log;
     };
 
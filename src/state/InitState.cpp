@@ -38,7 +38,7 @@ namespace ehb
         }
 
         // setup the NNK system and register it with OSG
-        auto callback = new FileNameMap(fileSys);
+        auto callback = new FileNameMap(fileSys, config.getString("cache-dir"));
         osgDB::Registry::instance()->setFindFileCallback(callback);
 
         // TODO: setup contentdb, world data, and other sub systems
@@ -46,16 +46,17 @@ namespace ehb
         // TODO: setup osg reader writers
         {
             osgDB::Registry::instance()->addReaderWriter(new ReaderWriterRAW(fileSys));
-            osgDB::Registry::instance()->addReaderWriter(new ReaderWriterSNO(fileSys));
+            osgDB::Registry::instance()->addReaderWriter(new ReaderWriterSNO(fileSys, config.getBool("compact-siege-nodes")));
             osgDB::Registry::instance()->addReaderWriter(new ReaderWriterASP(fileSys));
             osgDB::Registry::instance()->addReaderWriter(new ReaderWriterPRS(fileSys));
             osgDB::Registry::instance()->addReaderWriter(new ReaderWriterFont(fileSys));
-            osgDB::Registry::instance()->addReaderWriter(new ReaderWriterSiegeNodeList(fileSys));
+            osgDB::Registry::instance()->addReaderWriter(new ReaderWriterSiegeNodeList(fileSys, config.getBool("batch-regions")));
             osgDB::Registry::instance()->addReaderWriter(new ReaderWriterUI(fileSys, shell));
             
         }
 
-        contentDb.init(fileSys);
+        // pulling in templates on demand gets us to the first frame faster when only a handful of templates are needed
+        contentDb.init(fileSys, "/world/contentdb/templates/", config.getBool("lazy-contentdb"));
 
         // TODO: any asset and engine preloading from gas files
         if (auto stream = fileSys.createInputStream("/ui/config/preload_textures/preload_textures.gas"))
@@ -1,12 +1,23 @@
 
 #include "GasTestState.hpp"
 
+#include <map>
 #include <sstream>
+#include <iterator>
 
 #include <spdlog/spdlog.h>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
 
 #include "IFileSys.hpp"
+#include "ContentDb.hpp"
+#include "FuelCorpus.hpp"
+#include "FuelValidator.hpp"
 #include "gas/Fuel.hpp"
+#include "gas/FuelView.hpp"
+#include "gas/FuelScanner.hpp"
+#include "gas/FuelParser.hpp"
+#include "gas/FuelPreScanner.hpp"
 
 #define DOCTEST_CONFIG_IMPLEMENT
 #define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
@@ -41,6 +52,71 @@ namespace ehb
         log->error("{}", ss.str());
     }
 
+    //! gas files held in memory so ContentDb can be pointed at files the test edits and deletes
+    class MemoryFileSys final : public IFileSys
+    {
+    public:
+
+        std::map<std::string, std::string> files;
+
+        bool init(IConfig& config) override { return true; }
+
+        InputStream createInputStream(const std::string& filename) override
+        {
+            const auto itr = files.find(filename);
+
+            return itr != files.end() ? std::make_unique<std::istringstream>(itr->second) : nullptr;
+        }
+
+        FileList getFiles() const override
+        {
+            FileList result;
+
+            for (const auto& entry : files) result.insert(entry.first);
+
+            return result;
+        }
+
+        FileList getDirectoryContents(const std::string& directory) const override { return {}; }
+    };
+
+    static bool sameBlock(const FuelBlock* a, const FuelBlock* b)
+    {
+        if (a->name() != b->name() || a->type() != b->type()) return false;
+        if (a->valueCount() != b->valueCount() || a->eachChild().size() != b->eachChild().size()) return false;
+
+        for (unsigned int i = 0; i < a->valueCount(); ++i)
+        {
+            if (a->nameOf(i) != b->nameOf(i) || a->typeOf(i) != b->typeOf(i) || a->valueOf(i) != b->valueOf(i)) return false;
+        }
+
+        for (size_t i = 0; i < a->eachChild().size(); ++i)
+        {
+            if (!sameBlock(a->eachChild()[i], b->eachChild()[i])) return false;
+        }
+
+        return true;
+    }
+
+    static bool sameBlock(const FuelBlock* a, FuelViewBlock b)
+    {
+        if (a->name() != b.name() || a->type() != b.type() || a->valueCount() != b.valueCount()) return false;
+
+        for (unsigned int i = 0; i < a->valueCount(); ++i)
+        {
+            if (a->nameOf(i) != b.nameOf(i) || a->typeOf(i) != b.typeOf(i) || a->valueOf(i) != b.valueOf(i)) return false;
+        }
+
+        size_t index = 0;
+
+        for (FuelViewBlock child : b.eachChild())
+        {
+            if (index == a->eachChild().size() || !sameBlock(a->eachChild()[index++], child)) return false;
+        }
+
+        return index == a->eachChild().size();
+    }
+
     void GasTestState::enter()
     {
         auto log = spdlog::get("log");
@@ -401,6 +477,344 @@ namespace ehb
 
                 REQUIRE_EQ(new_wildcards->eachChild().size(), 4);
             }
+
+            // moving a temporary document in has to end up exactly like merging a copy of it
+            std::stringstream copy;
+            multiple_wildcard_merge->write(copy);
+
+            auto temporary = std::make_unique<Fuel>();
+            REQUIRE(temporary->load(copy));
+
+            auto moved_test_doc = newFuelDoc.appendChild("multiple_wildcard_move");
+            moved_test_doc->integrate(std::move(temporary));
+            REQUIRE(temporary == nullptr);
+
+            auto moved = moved_test_doc->child("multiple_wildcard_merge");
+            REQUIRE(moved != nullptr);
+            REQUIRE(moved->parent() == moved_test_doc);
+            REQUIRE(sameBlock(moved, new_test_doc));
+        }
+
+        // binary fuel test
+        std::stringstream().swap(*stream);
+        *stream << R"(
+            [t:template,n:binary_fuel]
+            {
+                doc = "binary fuel";
+                [aspect]
+                {
+                    model = m_c_gah_fg_pos_a1;
+                    f scale_base = 1.25;
+                    x flags = ff;
+                    b is_visible = true;
+                }
+            }
+        )";
+
+        if (Fuel doc; doc.load(*stream))
+        {
+            std::stringstream binary;
+            REQUIRE(doc.saveBinary(binary));
+
+            const std::string data = binary.str();
+
+            Fuel fromBinary;
+            REQUIRE(fromBinary.load(binary));
+            REQUIRE(sameBlock(&doc, &fromBinary));
+            REQUIRE(fromBinary.child("binary_fuel:aspect")->valueAsInt("flags") == 255);
+
+            FuelView view;
+            REQUIRE(view.open(data.data(), data.size()));
+            REQUIRE(sameBlock(&doc, view.root()));
+            REQUIRE(view.root().valueOf("binary_fuel:aspect:scale_base") == "1.25");
+            REQUIRE(view.root().valueOf("binary_fuel:aspect:missing", "default") == "default");
+
+            // a truncated document must be rejected instead of read past the end
+            REQUIRE(!view.open(data.data(), data.size() - 1));
+
+            // text has to be converted by Fuel first, a view only reads the binary layout
+            std::stringstream text;
+            REQUIRE(doc.save(text));
+
+            FuelView textView;
+            REQUIRE(!textView.load(text));
+
+            std::istringstream binaryStream(data);
+            REQUIRE(textView.load(binaryStream));
+
+            const FuelViewBlock aspect = textView.child("binary_fuel:aspect");
+            REQUIRE(aspect);
+            REQUIRE(aspect.parent().name() == "binary_fuel");
+            REQUIRE(aspect.valueAsFloat("scale_base") == 1.25f);
+            REQUIRE(aspect.valueAsUInt("flags") == 255);
+            REQUIRE(aspect.valueAsBool("is_visible"));
+            REQUIRE(aspect.typeOf("scale_base") == "f");
+            REQUIRE(textView.child("binary_fuel").valueAsString("doc") == "binary fuel");
+
+            unsigned int attrCount = 0;
+
+            for (const auto attr : aspect.eachAttribute())
+            {
+                REQUIRE(attr.value() == aspect.valueOf(attrCount++));
+            }
+
+            REQUIRE(attrCount == 4);
+            REQUIRE(textView.eachChildOf("binary_fuel").begin() != textView.eachChildOf("binary_fuel").end());
+            REQUIRE(textView.eachChildOf("missing").empty());
+        }
+
+        // every gas file has to survive text -> binary -> text without changing
+        {
+            osg::Timer timer;
+
+            size_t fileCount = 0, textBytes = 0, binaryBytes = 0;
+
+            for (const auto& filename : fileSys.getFiles())
+            {
+                if (osgDB::getLowerCaseFileExtension(filename) != "gas") continue;
+
+                auto file = fileSys.createInputStream(filename);
+
+                if (!file) continue;
+
+                const std::string text(std::istreambuf_iterator<char>(*file), {});
+
+                // files which don't parse are reported by everything else that loads them
+                std::istringstream textStream(text);
+
+                if (Fuel doc; doc.load(textStream))
+                {
+                    std::stringstream binary;
+                    REQUIRE(doc.saveBinary(binary));
+
+                    const std::string data = binary.str();
+
+                    Fuel fromBinary;
+                    REQUIRE(fromBinary.load(binary));
+                    CHECK_MESSAGE(sameBlock(&doc, &fromBinary), filename);
+
+                    FuelView view;
+                    REQUIRE(view.open(data.data(), data.size()));
+                    CHECK_MESSAGE(sameBlock(&doc, view.root()), filename);
+
+                    std::stringstream roundTrip;
+                    fromBinary.save(roundTrip);
+
+                    // save only writes the blocks of a document so compare block by block
+                    Fuel fromText;
+                    REQUIRE(fromText.load(roundTrip));
+                    REQUIRE_EQ(fromText.eachChild().size(), doc.eachChild().size());
+
+                    for (size_t i = 0; i < doc.eachChild().size(); ++i)
+                    {
+                        CHECK_MESSAGE(sameBlock(doc.eachChild()[i], fromText.eachChild()[i]), filename);
+                    }
+
+                    fileCount++;
+                    textBytes += text.size();
+                    binaryBytes += data.size();
+                }
+            }
+
+            log->info("binary fuel round trip of {} gas files took {:.3f}ms, {} KiB of text is {} KiB as binary", fileCount, timer.time_m(), textBytes / 1024, binaryBytes / 1024);
+        }
+
+        // corpus queries
+        {
+            FuelCorpus corpus;
+
+            std::istringstream actors(R"(
+                [t:actor,n:0x0001] { [aspect] { model = m_c_gah_fg_pos_a1; } [placement] { position = 1,2,3; } }
+                [t:actor,n:0x0002] { [placement] { position = 4,5,6; } }
+                [t:generator,n:0x0003] { [aspect] { model = m_i_glb_generator; } }
+            )");
+
+            std::istringstream templates(R"(
+                [t:template,n:gargoyle] { specializes = base_monster; [aspect] { model = m_c_gah_gg; } }
+                [t:template,n:base_monster] { [aspect] { scale_base = 1.0; } }
+            )");
+
+            REQUIRE(corpus.add("/world/maps/test/regions/r1/objects/actor.gas", actors));
+            REQUIRE(corpus.add("/world/contentdb/templates/monsters.gas", templates));
+            REQUIRE(corpus.fileCount() == 2);
+
+            REQUIRE(corpus.query("[t:actor]").size() == 2);
+            REQUIRE(corpus.query("[T:ACTOR]").size() == 2);
+            REQUIRE(corpus.query("[t:actor,n:0x0002]").size() == 1);
+            REQUIRE(corpus.query("[t:*] [aspect]").size() == 4);
+            REQUIRE(corpus.query("[t:actor] [aspect]").size() == 1);
+            REQUIRE(corpus.query("[t:template,a:specializes]").front().block.name() == "gargoyle");
+            REQUIRE(corpus.query("[n:*garg*]").size() == 1);
+            REQUIRE(corpus.query("[a:model]").size() == 3);
+            REQUIRE(corpus.query("/world/maps/*/regions/*/objects/*.gas [aspect]").size() == 2);
+            REQUIRE(corpus.query("/world/*.gas [aspect]").empty());
+            REQUIRE(corpus.query("/world/**.gas [aspect]").size() == 4);
+            REQUIRE(corpus.query("[t:template] [aspect]").front().filename == "/world/contentdb/templates/monsters.gas");
+            REQUIRE(corpus.query("[t:missing]").empty());
+            REQUIRE(corpus.query("[t:actor").empty());
+        }
+
+        // content db reloads, both eager and lazy
+        for (bool lazy : { false, true })
+        {
+            MemoryFileSys memoryFileSys;
+
+            // the parent and child live in one file, a grandchild and a second definition of the parent live in another
+            memoryFileSys.files["/templates/a.gas"] = "[t:template,n:parent] { x = 1; } [t:template,n:child] { specializes = parent; }";
+            memoryFileSys.files["/templates/b.gas"] = "[t:template,n:grandchild] { specializes = child; } [t:template,n:parent] { x = 2; }";
+
+            ContentDb contentDb;
+            contentDb.init(memoryFileSys, "/templates/", lazy);
+
+            REQUIRE(contentDb.queryString("grandchild:x") == "1");
+
+            // saving the file with the duplicate again doesn't take the template away from the file that defined it first
+            contentDb.reload("/templates/b.gas");
+            REQUIRE(contentDb.queryString("parent:x") == "1");
+
+            // deleting a file takes a parent and its child with it at once
+            memoryFileSys.files.erase("/templates/a.gas");
+            contentDb.reload("/templates/a.gas");
+
+            REQUIRE(contentDb.getGameObjectTmpl("parent") == nullptr);
+            REQUIRE(contentDb.getGameObjectTmpl("child") == nullptr);
+            REQUIRE(contentDb.getGameObjectTmpl("grandchild") != nullptr);
+            REQUIRE(contentDb.getGameObjectTmpl("grandchild")->specializes() == nullptr);
+        }
+
+        // parse diagnostics
+        {
+            Fuel recovered;
+            REQUIRE(recovered.parse("[a]\n{\n    x = 1;\n}\n[b] oops { y = 2; }\n"));
+            REQUIRE(recovered.diagnostics().size() == 1);
+            REQUIRE(recovered.diagnostics()[0].recovered);
+            REQUIRE(recovered.diagnostics()[0].line == 5);
+            REQUIRE(recovered.diagnostics()[0].column == 5);
+            REQUIRE(recovered.diagnostics()[0].offset == 23);
+            REQUIRE(recovered.child("b")->valueAsInt("y") == 2);
+
+            Fuel broken;
+            REQUIRE(!broken.parse("[a]\n{\n    x = 1;\n  @\n}\n"));
+            REQUIRE(!broken.diagnostics().empty());
+            REQUIRE(broken.diagnostics()[0].line == 4);
+            REQUIRE(broken.diagnostics()[0].column == 3);
+            REQUIRE(!broken.diagnostics()[0].recovered);
+
+            Fuel truncated;
+            REQUIRE(!truncated.parse("[a]\n{\n    x = 1;\n"));
+            REQUIRE(truncated.diagnostics().back().message == "syntax error at end of document");
+
+            // a clean load doesn't leave anything behind from the last one
+            REQUIRE(broken.parse("[a] { x = 1; }"));
+            REQUIRE(broken.diagnostics().empty());
+
+            for (const auto& result : FuelValidator::validate(fileSys))
+            {
+                CHECK_MESSAGE(result.loaded, result.filename);
+            }
+        }
+
+        // scanner only benchmark, every pre-scanner implementation has to give back exactly the same documents and tokens as the plain state machine
+        {
+            std::vector<std::string> texts;
+            size_t totalBytes = 0;
+
+            for (const auto& filename : fileSys.getFiles())
+            {
+                if (osgDB::getLowerCaseFileExtension(filename) != "gas") continue;
+
+                if (auto file = fileSys.createInputStream(filename))
+                {
+                    texts.emplace_back(std::istreambuf_iterator<char>(*file), std::istreambuf_iterator<char>());
+                    totalBytes += texts.back().size();
+                }
+            }
+
+            const FuelPreScanner::Isa best = FuelPreScanner::best();
+            const int passes = 10;
+
+            REQUIRE(FuelPreScanner::select(FuelPreScanner::Isa::Scalar));
+
+            std::vector<std::unique_ptr<Fuel>> reference;
+
+            for (const auto& text : texts)
+            {
+                std::istringstream textStream(text);
+
+                reference.push_back(std::make_unique<Fuel>());
+                reference.back()->load(textStream);
+            }
+
+            // pre-scanning hands back runs of expression text the state machine would return a byte or two at a time so join those up before comparing
+            auto tokenize = [](const std::string& text, bool preScan)
+            {
+                std::vector<std::pair<int, std::string>> tokens;
+
+                FuelScanner scanner(text.c_str(), nullptr, preScan);
+
+                while (true)
+                {
+                    // punctuation doesn't touch the value so start each token with an empty one
+                    std::string value;
+
+                    const int token = scanner.scan(&value);
+                    if (token == 0) break;
+
+                    if (token == FuelParser::token::Expression && !tokens.empty() && tokens.back().first == token)
+                    {
+                        tokens.back().second += value;
+                    }
+                    else
+                    {
+                        tokens.emplace_back(token, value);
+                    }
+                }
+
+                return tokens;
+            };
+
+            std::vector<std::vector<std::pair<int, std::string>>> referenceTokens;
+
+            for (const auto& text : texts)
+            {
+                referenceTokens.push_back(tokenize(text, false));
+            }
+
+            for (FuelPreScanner::Isa isa : { FuelPreScanner::Isa::Scalar, FuelPreScanner::Isa::SSE2, FuelPreScanner::Isa::AVX2, FuelPreScanner::Isa::NEON })
+            {
+                if (!FuelPreScanner::select(isa)) continue;
+
+                osg::Timer timer;
+                size_t tokenCount = 0;
+
+                for (int pass = 0; pass < passes; ++pass)
+                {
+                    for (const auto& text : texts)
+                    {
+                        FuelScanner scanner(text.c_str());
+                        std::string value;
+
+                        while (scanner.scan(&value) != 0) tokenCount++;
+                    }
+                }
+
+                const double duration = timer.time_m();
+
+                log->info("FuelScanner with {} pre-scanning: {} tokens in {:.3f}ms per pass, {:.1f} MiB/s", FuelPreScanner::name(isa), tokenCount / passes, duration / passes, (totalBytes * passes) / (1024.0 * 1024.0) / (duration / 1000.0));
+
+                for (size_t i = 0; i < texts.size(); ++i)
+                {
+                    std::istringstream textStream(texts[i]);
+
+                    Fuel doc;
+                    doc.load(textStream);
+
+                    CHECK(sameBlock(&doc, reference[i].get()));
+                    CHECK(tokenize(texts[i], true) == referenceTokens[i]);
+                }
+            }
+
+            FuelPreScanner::select(best);
         }
     }
 
@@ -2,22 +2,30 @@
 #include "RegionTestState.hpp"
 
 #include "IFileSys.hpp"
+#include "Parallel.hpp"
+#include "cfg/IConfig.hpp"
 #include "gas/Fuel.hpp"
 #include "osg/SiegeNodeMesh.hpp"
 #include "osg/Aspect.hpp"
 #include "ContentDb.hpp"
+#include "world/NavGraph.hpp"
 #include "world/Region.hpp"
 #include "spdlog/fmt/ostr.h"
 
+#include <algorithm>
+#include <functional>
+#include <random>
 #include <set>
+#include <unordered_map>
 #include <osgDB/ReadFile>
 #include <osg/Group>
 #include <osg/MatrixTransform>
 #include <osgDB/Options>
+#include <osg/Timer>
 #include <osg/ComputeBoundsVisitor>
 #include <osgViewer/Viewer>
 
-#include <osgUtil/Optimizer>
+#include <osgUtil/LineSegmentIntersector>
 
 namespace ehb
 {
@@ -58,11 +66,11 @@ static std::ostream& operator << (std::ostream& s, const ehb::SiegePos& pos)
 
 namespace ehb
 {
-    // since we are using software instancing we have to keep track of the guids of handled nodes as to not keep flipping things on and off
+    // since we are using software instancing we have to keep track of the meshes already handled as to not keep flipping things on and off
     class ToggleRegionLogicalFlags : public osg::NodeVisitor
     {
 
-        std::set<uint32_t> unique;
+        std::set<SiegeNodeMesh*> unique;
 
     public:
 
@@ -79,9 +87,8 @@ namespace ehb
                 {
                     if (SiegeNodeMesh* mesh = dynamic_cast<SiegeNodeMesh*>(xform->getChild(0)))
                     {
-                        uint32_t guid; xform->getUserValue("guid", guid);
-
-                        if (unique.insert(guid).second)
+                        // every node using the same mesh shares it so it only gets flipped the first time it's seen
+                        if (unique.insert(mesh).second)
                         {
                             mesh->toggleLogicalNodeFlags();
                         }
@@ -93,6 +100,385 @@ namespace ehb
         }
     };
 
+    /*
+     * reads the region once for each thread count from 1 up to every core, nothing holds on to the meshes between reads
+     * so every one of them is read from scratch. an untimed read first gets the files into the os cache
+     */
+    static void benchmarkRegionLoad(const std::string& nodesDotGas)
+    {
+        auto log = spdlog::get("log");
+
+        std::vector<unsigned int> threadCounts;
+
+        for (unsigned int threadCount = 1; threadCount < defaultThreadCount(); threadCount *= 2)
+        {
+            threadCounts.push_back(threadCount);
+        }
+
+        threadCounts.push_back(defaultThreadCount());
+
+        osgDB::readRefNodeFile(nodesDotGas);
+
+        double singleThreaded = 0;
+
+        for (unsigned int threadCount : threadCounts)
+        {
+            osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+            options->setPluginStringData("threadcount", std::to_string(threadCount));
+
+            osg::Timer timer;
+
+            osg::ref_ptr<osg::Node> region = osgDB::readRefNodeFile(nodesDotGas, options.get());
+
+            const double time = timer.time_m();
+
+            if (threadCount == 1) singleThreaded = time;
+
+            log->info("region load benchmark: {} took {:.3f}ms on {} threads ({:.2f}x)", nodesDotGas, time, threadCount, singleThreaded / time);
+        }
+    }
+
+    /*
+     * times height queries and rays against the floor and water faces through the region, then a slice of the same rays
+     * through the scene graph the way picking does it. the points are random but seeded so runs can be compared
+     */
+    static void benchmarkSurfaceQueries(Region& region)
+    {
+        auto log = spdlog::get("log");
+
+        const osg::BoundingBox& bounds = region.surfaceBounds();
+
+        if (!bounds.valid())
+        {
+            log->warn("surface benchmark: the region has no floor or water faces");
+
+            return;
+        }
+
+        constexpr size_t queryCount = 100000, graphQueryCount = 1000;
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> x(bounds.xMin(), bounds.xMax()), y(bounds.yMin(), bounds.yMax()), z(bounds.zMin(), bounds.zMax());
+
+        std::vector<osg::Vec3> starts(queryCount), ends(queryCount);
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            starts[i].set(x(random), bounds.yMax() + 1.0f, z(random));
+            ends[i].set(x(random), y(random), z(random));
+        }
+
+        size_t found = 0;
+        Region::SurfaceHit hit;
+
+        osg::Timer timer;
+
+        for (const osg::Vec3& point : starts)
+        {
+            if (region.heightAt(point, hit)) found++;
+        }
+
+        const double heightTime = timer.time_m();
+
+        log->info("surface benchmark: {} height queries took {:.3f}ms ({:.0f} a second), {} found ground", queryCount, heightTime, queryCount / heightTime * 1000.0, found);
+
+        found = 0;
+        timer.setStartTick();
+
+        std::vector<Region::SurfaceHit> serialHits(queryCount);
+        std::vector<char> serialFound(queryCount);
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            serialFound[i] = region.raycast(starts[i], ends[i], serialHits[i]);
+
+            if (serialFound[i]) found++;
+        }
+
+        const double rayTime = timer.time_m();
+
+        log->info("surface benchmark: {} rays took {:.3f}ms ({:.0f} a second), {} hit", queryCount, rayTime, queryCount / rayTime * 1000.0, found);
+
+        // the queries only read the region so they can be spread over every core
+        std::vector<Region::SurfaceHit> hits(queryCount);
+        std::vector<char> hitFound(queryCount);
+
+        timer.setStartTick();
+
+        parallelFor(queryCount, [&region, &starts, &ends, &hits, &hitFound](size_t i)
+            {
+                hitFound[i] = region.raycast(starts[i], ends[i], hits[i]);
+            });
+
+        const double parallelTime = timer.time_m();
+
+        log->info("surface benchmark: {} rays took {:.3f}ms on {} threads ({:.0f} a second)", queryCount, parallelTime, defaultThreadCount(), queryCount / parallelTime * 1000.0);
+
+        size_t mismatches = 0;
+
+        for (size_t i = 0; i < queryCount; ++i)
+        {
+            if (hitFound[i] != serialFound[i] || (hitFound[i] && (hits[i].guid != serialHits[i].guid || hits[i].ratio != serialHits[i].ratio)))
+            {
+                mismatches++;
+            }
+        }
+
+        if (mismatches != 0)
+        {
+            log->error("surface benchmark: {} of {} rays hit something different on {} threads than on one", mismatches, queryCount, defaultThreadCount());
+        }
+
+        found = 0;
+        timer.setStartTick();
+
+        std::vector<osg::ref_ptr<osgUtil::LineSegmentIntersector>> intersectors(graphQueryCount);
+
+        for (size_t i = 0; i < graphQueryCount; ++i)
+        {
+            intersectors[i] = new osgUtil::LineSegmentIntersector(osgUtil::Intersector::MODEL, starts[i], ends[i]);
+            osgUtil::IntersectionVisitor visitor(intersectors[i]);
+
+            region.accept(visitor);
+
+            if (intersectors[i]->containsIntersections()) found++;
+        }
+
+        const double graphTime = timer.time_m();
+
+        log->info("surface benchmark: {} rays through the scene graph took {:.3f}ms ({:.0f} a second), {} hit, the region is {:.1f}x faster",
+            graphQueryCount, graphTime, graphQueryCount / graphTime * 1000.0, found, (graphTime / graphQueryCount) / (rayTime / queryCount));
+
+        /*
+         * the scene graph is the drawn geometry rather than the logical node faces so it also hits walls and anything else in
+         * the way, but wherever the region finds floor the drawn floor should be there too. every ray the region says hit
+         * has to hit the scene graph no further along than it, give or take a little for the two not lining up exactly
+         */
+        size_t checked = 0, missed = 0;
+
+        for (size_t i = 0; i < graphQueryCount; ++i)
+        {
+            if (!serialFound[i]) continue;
+
+            checked++;
+
+            const float tolerance = 0.1f / std::max((ends[i] - starts[i]).length(), 1e-6f);
+
+            if (!intersectors[i]->containsIntersections() || intersectors[i]->getFirstIntersection().ratio > serialHits[i].ratio + tolerance)
+            {
+                missed++;
+            }
+        }
+
+        if (missed != 0)
+        {
+            log->warn("surface benchmark: {} of {} rays the region hit found nothing that close through the scene graph", missed, checked);
+        }
+        else
+        {
+            log->info("surface benchmark: all {} rays the region hit found the scene graph at or before the same spot", checked);
+        }
+    }
+
+    /*
+     * builds the navigation graph and times paths between random points over the region, first searched on one thread,
+     * then on every core and then again straight from the cache
+     */
+    static void benchmarkPathQueries(const Region& region)
+    {
+        auto log = spdlog::get("log");
+
+        const osg::BoundingBox& bounds = region.surfaceBounds();
+
+        if (!bounds.valid()) return;
+
+        constexpr size_t queryCount = 10000;
+
+        osg::Timer timer;
+
+        NavGraph graph(region, queryCount);
+
+        const double buildTime = timer.time_m();
+        const NavGraph::Stats graphStats = graph.stats();
+
+        log->info("path benchmark: built a graph of {} nodes with {} doors and {} logical nodes with {} edges in {:.3f}ms",
+            graphStats.siegeNodes, graphStats.doorEdges, graphStats.logicalNodes, graphStats.logicalEdges, buildTime);
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> x(bounds.xMin(), bounds.xMax()), z(bounds.zMin(), bounds.zMax());
+
+        std::vector<NavGraph::Query> queries(queryCount);
+
+        for (NavGraph::Query& query : queries)
+        {
+            query.start.set(x(random), bounds.yMax() + 1.0f, z(random));
+            query.goal.set(x(random), bounds.yMax() + 1.0f, z(random));
+        }
+
+        timer.setStartTick();
+
+        const std::vector<NavGraph::Path> paths = graph.findPaths(queries, 1);
+
+        const double singleTime = timer.time_m();
+
+        size_t found = 0, steps = 0;
+
+        for (const NavGraph::Path& path : paths)
+        {
+            if (path.found)
+            {
+                found++;
+                steps += path.steps.size();
+            }
+        }
+
+        log->info("path benchmark: {} paths took {:.3f}ms ({:.0f} a second), {} found averaging {:.1f} logical nodes", queryCount, singleTime,
+            queryCount / singleTime * 1000.0, found, found == 0 ? 0.0 : double(steps) / found);
+
+        // a fresh graph so every path is searched for again rather than taken from the cache
+        NavGraph parallelGraph(region, queryCount);
+
+        timer.setStartTick();
+        parallelGraph.findPaths(queries);
+
+        const double parallelTime = timer.time_m();
+
+        log->info("path benchmark: {} paths took {:.3f}ms on {} threads ({:.2f}x)", queryCount, parallelTime, defaultThreadCount(), singleTime / parallelTime);
+
+        timer.setStartTick();
+        parallelGraph.findPaths(queries);
+
+        const double cachedTime = timer.time_m();
+        const NavGraph::Stats cacheStats = parallelGraph.stats();
+
+        log->info("path benchmark: the same {} paths again took {:.3f}ms, {} searches and {} cache hits so far", queryCount, cachedTime,
+            cacheStats.searches, cacheStats.cacheHits);
+    }
+
+    /*
+     * places a synthetic region of 10000 nodes all using the mesh of the target node, each one hanging off one of the few
+     * nodes added before it so the door graph runs thousands of nodes deep. it is placed once by the region itself and,
+     * for comparison, the way regions used to be placed by recursing through a map of doors. the recursion only gets the
+     * nodes near the top of the graph since going thousands of calls deep would run out of stack
+     */
+    static void benchmarkDoorPlacement(const Region& region)
+    {
+        auto log = spdlog::get("log");
+
+        const osg::MatrixTransform* targetNodeXform = region.targetNode();
+        const SiegeNodeMesh* mesh = targetNodeXform ? dynamic_cast<const SiegeNodeMesh*>(targetNodeXform->getChild(0)) : nullptr;
+
+        if (mesh == nullptr || mesh->doorMatrices().empty())
+        {
+            log->warn("door placement benchmark: the target node has no doors to build a region from");
+
+            return;
+        }
+
+        constexpr uint32_t nodeCount = 10000, firstGuid = 0x1000;
+
+        // each level of the recursion is a few std::function frames, this stays well inside a 1MB stack
+        constexpr uint32_t recursionDepth = 256;
+
+        std::mt19937 random(1234);
+
+        const auto& doors = mesh->doorMatrices();
+
+        std::vector<Region::DoorLink> links;
+        std::vector<uint32_t> depth(nodeCount, 0);
+
+        for (uint32_t i = 1; i < nodeCount; ++i)
+        {
+            const uint32_t parent = i - 1 - std::min<uint32_t>(i - 1, random() % 4);
+            const uint32_t door = doors[random() % doors.size()].first, farDoor = doors[random() % doors.size()].first;
+
+            // both nodes list the door like nodes.gas does
+            links.push_back(Region::DoorLink{ firstGuid + parent, door, firstGuid + i, farDoor });
+            links.push_back(Region::DoorLink{ firstGuid + i, farDoor, firstGuid + parent, door });
+
+            depth[i] = depth[parent] + 1;
+        }
+
+        SiegeNodeMesh* sharedMesh = const_cast<SiegeNodeMesh*>(mesh);
+
+        // the old way, kept here to compare against
+        {
+            std::unordered_map<uint32_t, osg::ref_ptr<osg::MatrixTransform>> nodeMap;
+            std::unordered_multimap<uint32_t, Region::DoorLink> doorMap;
+            std::set<uint32_t> completeSet;
+
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                if (depth[i] > recursionDepth) continue;
+
+                osg::ref_ptr<osg::MatrixTransform> xform = new osg::MatrixTransform;
+                xform->addChild(sharedMesh);
+
+                nodeMap.emplace(firstGuid + i, xform);
+            }
+
+            for (const Region::DoorLink& link : links)
+            {
+                if (nodeMap.count(link.guid) != 0 && nodeMap.count(link.farGuid) != 0)
+                {
+                    doorMap.emplace(link.guid, link);
+                }
+            }
+
+            osg::Timer timer;
+
+            std::function<void(const uint32_t)> func = [&func, &doorMap, &nodeMap, &completeSet](const uint32_t guid)
+            {
+                if (completeSet.insert(guid).second)
+                {
+                    osg::ref_ptr<osg::MatrixTransform> targetNode = nodeMap.at(guid);
+
+                    const auto range = doorMap.equal_range(guid);
+
+                    for (auto entry = range.first; entry != range.second; ++entry)
+                    {
+                        SiegeNodeMesh::connect(targetNode, entry->second.door, nodeMap.at(entry->second.farGuid), entry->second.farDoor);
+
+                        if (completeSet.count(entry->second.farGuid) == 0)
+                        {
+                            func(entry->second.farGuid);
+                        }
+                    }
+                }
+            };
+
+            func(firstGuid);
+
+            const double time = timer.time_m();
+
+            log->info("door placement benchmark: recursing placed {} nodes up to {} deep in {:.3f}ms ({:.3f}us a node)", completeSet.size(), recursionDepth, time, time * 1000.0 / completeSet.size());
+        }
+
+        osg::ref_ptr<Region> synthetic = new Region;
+
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            osg::ref_ptr<osg::MatrixTransform> xform = new osg::MatrixTransform;
+            xform->addChild(sharedMesh);
+
+            synthetic->addNode(firstGuid + i, xform);
+        }
+
+        for (const Region::DoorLink& link : links)
+        {
+            synthetic->addDoorLink(link);
+        }
+
+        osg::Timer timer;
+
+        const Region::PlacementStats placement = synthetic->placeNodes(firstGuid);
+
+        const double time = timer.time_m();
+
+        log->info("door placement benchmark: the region placed {} nodes {} deep through {} doors in {:.3f}ms ({:.3f}us a node)", placement.placed,
+            *std::max_element(depth.begin(), depth.end()), placement.connections, time, time * 1000.0 / std::max<size_t>(placement.placed, 1));
+    }
+
     void RegionTestState::enter()
     {
         log = spdlog::get("log");
@@ -112,8 +498,20 @@ namespace ehb
         const std::string nodesDotGas = regionPath + "/terrain_nodes/nodes.gas";
         const std::string objectsPath = regionPath + "/objects/regular/";
 
+        if (config.getBool("region-benchmark"))
+        {
+            benchmarkRegionLoad(nodesDotGas);
+        }
+
         region = static_cast<Region*> (osgDB::readNodeFile(nodesDotGas));
 
+        if (config.getBool("region-benchmark"))
+        {
+            benchmarkSurfaceQueries(*region);
+            benchmarkPathQueries(*region);
+            benchmarkDoorPlacement(*region);
+        }
+
         const osg::MatrixTransform* targetNodeXform = region->targetNode();
         uint32_t targetNodeGuid = region->targetNodeGuid();
 
@@ -201,9 +599,8 @@ namespace ehb
         }
 #endif
 
-        osgUtil::Optimizer optimizer;
-        optimizer.optimize(region);
-
+        // the optimizer isn't run over the region, the nodes share their meshes with each other and with every other region
+        // so flattening transforms or merging geometry into them would move every other node using the same mesh too
         scene.addChild(region);
     }
 
@@ -242,16 +639,22 @@ namespace ehb
                                     {
                                         log->info("node you clicked was: 0x{:x}", nodeGuid);
 
-                                        if (selectedSiegeNode != nullptr)
+                                        // the mesh is shared by every node using it so the debug drawing goes under the transform of the one clicked
+                                        if (selectedNode != nullptr)
                                         {
-                                            selectedSiegeNode->toggleBoundingBox();
-                                            selectedSiegeNode->toggleAllDoorLabels();
+                                            if (SiegeNodeMesh* mesh = dynamic_cast<SiegeNodeMesh*>(selectedNode->getChild(0)))
+                                            {
+                                                selectedNode->removeChild(mesh->debugBoundingBox());
+                                                selectedNode->removeChild(mesh->debugDoorLabels());
+                                            }
                                         }
 
-                                        if (selectedSiegeNode = static_cast<SiegeNodeMesh*>(nodeXform->getChild(0)); selectedSiegeNode != nullptr)
+                                        selectedNode = nodeXform;
+
+                                        if (SiegeNodeMesh* mesh = dynamic_cast<SiegeNodeMesh*>(selectedNode->getChild(0)))
                                         {
-                                            selectedSiegeNode->toggleBoundingBox();
-                                            selectedSiegeNode->toggleAllDoorLabels();
+                                            selectedNode->addChild(mesh->debugBoundingBox());
+                                            selectedNode->addChild(mesh->debugDoorLabels());
                                         }
                                     }
                                 }
@@ -269,16 +672,6 @@ namespace ehb
 
                 ToggleRegionLogicalFlags visitor;
                 region->accept(visitor);
-
-                static bool runOnce = false;
-
-                if (!runOnce)
-                {
-                    osgUtil::Optimizer optimizer;
-                    optimizer.optimize(region);
-
-                    runOnce = true;
-                }
             }
         }
 
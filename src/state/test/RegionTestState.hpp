@@ -46,7 +46,8 @@ namespace ehb
         osg::Group& scene;
 
         Region* region = nullptr;
-        SiegeNodeMesh* selectedSiegeNode = nullptr;
+        //! the transform of the node last clicked, its debug drawing hangs off of it since the mesh is shared with other nodes
+        osg::MatrixTransform* selectedNode = nullptr;
         
         std::shared_ptr<spdlog::logger> log;
     };
@@ -1,22 +1,208 @@
 
 #include "SiegeNodeTestState.hpp"
 
+#include <atomic>
+#include <cmath>
+#include <random>
 #include <sstream>
+#include <thread>
 
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
 #include <osg/MatrixTransform>
 #include <osg/Group>
 #include <osgViewer/Viewer>
 #include <spdlog/spdlog.h>
 
+#include "IFileSys.hpp"
+#include "Parallel.hpp"
 #include "osg/SiegeNodeMesh.hpp"
+#include "osg/FileNameMap.hpp"
 
 namespace ehb
 {
+    /*
+     * resolve every file under /art by its bare name, which is how the osg plugins ask for them, from every core at once
+     * while another thread keeps reloading the naming keys. every answer has to match the single threaded one, any that
+     * don't are logged as an error
+     */
+    static void stressFileNameMap(IFileSys & fileSys)
+    {
+        auto log = spdlog::get("game");
+
+        std::vector<std::string> names;
+
+        for (const auto & filename : fileSys.getFiles())
+        {
+            if (filename.compare(0, 5, "/art/") == 0)
+            {
+                names.emplace_back(osgDB::getSimpleFileName(filename));
+            }
+        }
+
+        osg::ref_ptr<FileNameMap> fileNameMap = new FileNameMap(fileSys);
+
+        std::vector<std::string> expected;
+        expected.reserve(names.size());
+
+        for (const auto & name : names)
+        {
+            expected.emplace_back(fileNameMap->findDataFile(name, nullptr, osgDB::CASE_SENSITIVE));
+        }
+
+        const unsigned int threadCount = std::max(2u, defaultThreadCount());
+
+        std::atomic<size_t> lookups = 0, mismatches = 0;
+        std::atomic<bool> reloading = true;
+
+        osg::Timer timer;
+
+        std::thread reloader([&fileSys, &fileNameMap, &reloading]
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    fileNameMap->reload(fileSys);
+                }
+
+                reloading = false;
+            });
+
+        parallelFor(threadCount, [&](size_t thread)
+            {
+                size_t count = 0, wrong = 0;
+
+                // keep going until the reloads are done so lookups are racing the swaps the whole time
+                for (size_t pass = 0; pass < 2 || reloading; ++pass)
+                {
+                    // each thread starts at a different spot so they aren't all filling in the same cache slots together
+                    for (size_t i = 0, index = thread * names.size() / threadCount; i < names.size(); ++i, index = (index + 1) % names.size())
+                    {
+                        if (fileNameMap->findDataFile(names[index], nullptr, osgDB::CASE_SENSITIVE) != expected[index])
+                        {
+                            wrong++;
+                        }
+
+                        count++;
+                    }
+                }
+
+                lookups += count;
+                mismatches += wrong;
+            }, threadCount);
+
+        reloader.join();
+
+        if (mismatches != 0)
+        {
+            log->error("FileNameMap stress test: {} of {} lookups across {} threads resolved differently than on a single thread", mismatches.load(), lookups.load(), threadCount);
+
+            return;
+        }
+
+        log->info("FileNameMap stress test: {} lookups of {} names across {} threads with 4 reloads took {:.3f}ms", lookups.load(), names.size(), threadCount, timer.time_m());
+    }
+
+    /*
+     * fires random segments through the logical node boxes of mesh and checks every one finds the same face walking the box
+     * trees as it does with the trees set aside, which makes intersect test every face. the segments are seeded so runs
+     * can be compared
+     */
+    static void checkBoxTrees(SiegeNodeMesh & mesh)
+    {
+        auto log = spdlog::get("game");
+
+        osg::BoundingBox bounds;
+        size_t treeCount = 0;
+
+        for (const auto & grouping : mesh.logicalNodeGroupings)
+        {
+            bounds.expandBy(grouping.bbox);
+
+            if (!grouping.boxTree.empty()) treeCount++;
+        }
+
+        if (!bounds.valid() || treeCount == 0)
+        {
+            log->warn("box tree check: the mesh has no logical node box trees to check");
+
+            return;
+        }
+
+        // start and end a little outside the boxes so segments pass all the way through some of them
+        const osg::Vec3 margin = (bounds._max - bounds._min) * 0.25f;
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> x(bounds.xMin() - margin.x(), bounds.xMax() + margin.x());
+        std::uniform_real_distribution<float> y(bounds.yMin() - margin.y(), bounds.yMax() + margin.y());
+        std::uniform_real_distribution<float> z(bounds.zMin() - margin.z(), bounds.zMax() + margin.z());
+
+        constexpr size_t segmentCount = 10000;
+
+        std::vector<osg::Vec3> starts(segmentCount), ends(segmentCount);
+        std::vector<SiegeNodeMesh::FaceHit> treeHits(segmentCount);
+        std::vector<char> treeFound(segmentCount);
+
+        for (size_t i = 0; i < segmentCount; ++i)
+        {
+            starts[i].set(x(random), y(random), z(random));
+            ends[i].set(x(random), y(random), z(random));
+
+            treeFound[i] = mesh.intersect(starts[i], ends[i], treeHits[i]);
+        }
+
+        std::vector<std::vector<SiegeNodeMesh::BoxTreeNode>> trees;
+
+        for (auto & grouping : mesh.logicalNodeGroupings)
+        {
+            trees.emplace_back(std::move(grouping.boxTree));
+            grouping.boxTree.clear();
+        }
+
+        size_t hits = 0, mismatches = 0;
+
+        for (size_t i = 0; i < segmentCount; ++i)
+        {
+            SiegeNodeMesh::FaceHit hit;
+
+            const bool found = mesh.intersect(starts[i], ends[i], hit);
+
+            if (found) hits++;
+
+            // two faces sharing an edge can both be first along a segment, either one is right as long as it is as close
+            if (found != static_cast<bool>(treeFound[i]) || (found && std::abs(hit.ratio - treeHits[i].ratio) > 1e-5f))
+            {
+                if (mismatches++ == 0)
+                {
+                    log->error("box tree check: segment {} found {} at {} walking the trees and {} at {} testing every face", i, static_cast<bool>(treeFound[i]), treeHits[i].ratio, found, hit.ratio);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < trees.size(); ++i)
+        {
+            mesh.logicalNodeGroupings[i].boxTree = std::move(trees[i]);
+        }
+
+        if (mismatches != 0)
+        {
+            log->error("box tree check: {} of {} segments hit something different walking the trees than testing every face", mismatches, segmentCount);
+
+            return;
+        }
+
+        log->info("box tree check: {} segments through {} logical nodes with trees gave the same {} hits as testing every face", segmentCount, treeCount, hits);
+    }
+
     void SiegeNodeTestState::enter()
     {
         auto log = spdlog::get("game");
 
+        if (config.getBool("siegenode-benchmark"))
+        {
+            stressFileNameMap(fileSys);
+        }
+
         // static const std::string meshName = "t_grs01_houses_generic-a-log.sno";
         static const std::string meshName = "t_xxx_wal_08-thck.sno";
 
@@ -25,6 +211,11 @@ namespace ehb
         {
             log->info("Loaded {}", meshName);
 
+            if (config.getBool("siegenode-benchmark"))
+            {
+                checkBoxTrees(*mesh);
+            }
+
             auto t1 = new osg::MatrixTransform;
             t1->addChild(mesh);
 
@@ -0,0 +1,96 @@
+
+/*
+ * converts gas files between text and binary fuel (.gasb)
+ *
+ *   GasConverter <file.gas> [file.gasb]     text to binary
+ *   GasConverter <file.gasb> [file.gas]     binary to text
+ *   GasConverter <directory>                every .gas file below directory to a .gasb next to it
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "gas/Fuel.hpp"
+#include "gas/FuelBinary.hpp"
+#include "filesystem/MappedFile.hpp"
+
+namespace fs = std::filesystem;
+
+using namespace ehb;
+
+static bool convert(const fs::path& input, const fs::path& output)
+{
+    MappedFile file;
+
+    // empty files can't be mapped but there are plenty of them in the stock gas files
+    if (!file.open(input.string()) && !(fs::exists(input) && fs::file_size(input) == 0))
+    {
+        std::cerr << input.string() << ": could not open" << std::endl;
+
+        return false;
+    }
+
+    const bool binary = FuelBinary::isBinary(file.data(), file.size());
+
+    Fuel doc;
+
+    if (binary ? !FuelBinary::read(file.data(), file.size(), doc) : !doc.load(input.string()))
+    {
+        std::cerr << input.string() << ": could not parse" << std::endl;
+
+        return false;
+    }
+
+    std::ofstream stream(output, std::ios_base::binary);
+
+    if (binary ? !doc.save(stream) : !doc.saveBinary(stream))
+    {
+        std::cerr << output.string() << ": could not write" << std::endl;
+
+        return false;
+    }
+
+    std::cout << input.string() << " (" << file.size() << " bytes) -> " << output.string() << " (" << stream.tellp() << " bytes)" << std::endl;
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <file.gas|file.gasb|directory> [output]" << std::endl;
+
+        return 1;
+    }
+
+    const fs::path input = argv[1];
+    const auto start = std::chrono::steady_clock::now();
+
+    int failed = 0, converted = 0;
+
+    if (fs::is_directory(input))
+    {
+        for (const auto& entry : fs::recursive_directory_iterator(input))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".gas")
+            {
+                convert(entry.path(), fs::path(entry.path()).replace_extension(".gasb")) ? converted++ : failed++;
+            }
+        }
+    }
+    else
+    {
+        fs::path output = argc > 2 ? fs::path(argv[2]) : fs::path(input).replace_extension(input.extension() == ".gasb" ? ".gas" : ".gasb");
+
+        convert(input, output) ? converted++ : failed++;
+    }
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "converted " << converted << " files in " << elapsed << "ms, " << failed << " failed" << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
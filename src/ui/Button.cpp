@@ -3,7 +3,7 @@
 
 #include <algorithm>
 #include <spdlog/spdlog.h>
-#include <osgDB/ReadFile>
+#include "osg/TextureCache.hpp"
 #include "Shell.hpp"
 #include "WidgetComponent.hpp"
 
@@ -28,9 +28,9 @@ namespace ehb
         osg::ref_ptr<osg::Switch> base = new osg::Switch;
 
         {
-            auto up = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_up") + ".raw");
-            auto down = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_down") + ".raw");
-            auto hov = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_hov") + ".raw");
+            auto up = TextureCache::instance().image(shell.mapCtrlArt(value + "_up") + ".raw");
+            auto down = TextureCache::instance().image(shell.mapCtrlArt(value + "_down") + ".raw");
+            auto hov = TextureCache::instance().image(shell.mapCtrlArt(value + "_hov") + ".raw");
 
             if (up && down && hov)
             {
@@ -48,9 +48,9 @@ namespace ehb
         }
 
         {
-            auto up = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_button_up") + ".raw");
-            auto down = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_button_down") + ".raw");
-            auto hov = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_button_hov") + ".raw");
+            auto up = TextureCache::instance().image(shell.mapCtrlArt(value + "_button_up") + ".raw");
+            auto down = TextureCache::instance().image(shell.mapCtrlArt(value + "_button_down") + ".raw");
+            auto hov = TextureCache::instance().image(shell.mapCtrlArt(value + "_button_hov") + ".raw");
 
             if (up && down && hov)
             {
@@ -68,34 +68,34 @@ namespace ehb
         }
 
         {
-            auto leftUp = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_left_up") + ".raw");
-            auto leftDown = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_left_down") + ".raw");
-            auto leftHov = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_left_hov") + ".raw");
+            auto leftUp = TextureCache::instance().image(shell.mapCtrlArt(value + "_left_up") + ".raw");
+            auto leftDown = TextureCache::instance().image(shell.mapCtrlArt(value + "_left_down") + ".raw");
+            auto leftHov = TextureCache::instance().image(shell.mapCtrlArt(value + "_left_hov") + ".raw");
 
-            auto centerUp = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_center_up") + ".raw");
-            auto centerDown = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_center_down") + ".raw");
-            auto centerHov = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_center_hov") + ".raw");
+            auto centerUp = TextureCache::instance().image(shell.mapCtrlArt(value + "_center_up") + ".raw");
+            auto centerDown = TextureCache::instance().image(shell.mapCtrlArt(value + "_center_down") + ".raw");
+            auto centerHov = TextureCache::instance().image(shell.mapCtrlArt(value + "_center_hov") + ".raw");
 
-            auto rightUp = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_right_up") + ".raw");
-            auto rightDown = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_right_down") + ".raw");
-            auto rightHov = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_right_hov") + ".raw");
+            auto rightUp = TextureCache::instance().image(shell.mapCtrlArt(value + "_right_up") + ".raw");
+            auto rightDown = TextureCache::instance().image(shell.mapCtrlArt(value + "_right_down") + ".raw");
+            auto rightHov = TextureCache::instance().image(shell.mapCtrlArt(value + "_right_hov") + ".raw");
 
             if (!leftUp && !leftDown && !leftHov && !centerUp && !centerDown && !centerHov && !rightUp && !rightDown && !rightHov)
             {
                 std::string value2 = value;
                 value2.erase(std::remove(value2.begin(), value2.end(), '_'), value2.end());
 
-                leftUp = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_left_up") + ".raw");
-                leftDown = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_left_down") + ".raw");
-                leftHov = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_left_hov") + ".raw");
+                leftUp = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_left_up") + ".raw");
+                leftDown = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_left_down") + ".raw");
+                leftHov = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_left_hov") + ".raw");
 
-                centerUp = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_center_up") + ".raw");
-                centerDown = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_center_down") + ".raw");
-                centerHov = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_center_hov") + ".raw");
+                centerUp = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_center_up") + ".raw");
+                centerDown = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_center_down") + ".raw");
+                centerHov = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_center_hov") + ".raw");
 
-                rightUp = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_right_up") + ".raw");
-                rightDown = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_right_down") + ".raw");
-                rightHov = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_right_hov") + ".raw");
+                rightUp = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_right_up") + ".raw");
+                rightDown = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_right_down") + ".raw");
+                rightHov = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_right_hov") + ".raw");
             }
 
             if (leftUp && leftDown && leftHov && centerUp && centerDown && centerHov && rightUp && rightDown && rightHov)
@@ -2,7 +2,7 @@
 #include "DialogBox.hpp"
 
 #include <spdlog/spdlog.h>
-#include <osgDB/ReadFile>
+#include "osg/TextureCache.hpp"
 #include "Shell.hpp"
 #include "WidgetComponent.hpp"
 
@@ -20,15 +20,15 @@ namespace ehb
     {
         auto log = spdlog::get("log");
 
-        auto bottomLeftCornerImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_bottom_left_corner") + ".raw");
-        auto bottomRightCornerImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_bottom_right_corner") + ".raw");
-        auto bottomSideImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_bottom_side") + ".raw");
-        auto leftSideImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_left_side") + ".raw");
-        auto rightSideImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_right_side") + ".raw");
-        auto topLeftCornerImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_top_left_corner") + ".raw");
-        auto topRightCornerImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_top_right_corner") + ".raw");
-        auto topSideImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_top_side") + ".raw");
-        auto fillImage = osgDB::readRefImageFile(shell.mapCtrlArt(value + "_fill") + ".raw");
+        auto bottomLeftCornerImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_bottom_left_corner") + ".raw");
+        auto bottomRightCornerImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_bottom_right_corner") + ".raw");
+        auto bottomSideImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_bottom_side") + ".raw");
+        auto leftSideImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_left_side") + ".raw");
+        auto rightSideImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_right_side") + ".raw");
+        auto topLeftCornerImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_top_left_corner") + ".raw");
+        auto topRightCornerImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_top_right_corner") + ".raw");
+        auto topSideImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_top_side") + ".raw");
+        auto fillImage = TextureCache::instance().image(shell.mapCtrlArt(value + "_fill") + ".raw");
 
         if (!fillImage)
         {
@@ -40,7 +40,7 @@ namespace ehb
 
                 log->info("DialogBox({}): searching for {}_fill instead of {}_fill", value2, value);
 
-                fillImage = osgDB::readRefImageFile(shell.mapCtrlArt(value2 + "_fill") + ".raw");
+                fillImage = TextureCache::instance().image(shell.mapCtrlArt(value2 + "_fill") + ".raw");
             }
         }
 
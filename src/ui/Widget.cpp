@@ -3,9 +3,9 @@
 
 #include "Shell.hpp"
 #include "gas/Fuel.hpp"
+#include "osg/TextureCache.hpp"
 
 #include <osg/Geometry>
-#include <osgDB/ReadFile>
 #include <osg/Texture2D>
 
 #include <spdlog/spdlog.h>
@@ -62,7 +62,7 @@ namespace ehb
     {
         // TODO: if common control do nothing?
 
-        if (auto image = osgDB::readRefImageFile(textureFileName + ".raw"))
+        if (auto image = TextureCache::instance().image(textureFileName + ".raw"))
         {
             if (resizeWidget)
             {
@@ -76,7 +76,7 @@ namespace ehb
             }
             else
             {
-                osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
+                osg::ref_ptr<osg::Texture2D> texture = TextureCache::instance().texture(image, TextureCache::Wrap::Clamp);
                 auto geometry = static_cast<osg::Geometry*>(baseComponent->getChild(0));
                 geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
             }
@@ -141,19 +141,16 @@ namespace ehb
         {
             tiled = value;
 
-            if (auto blah = baseComponent->getChild(0)->getOrCreateStateSet()->getTextureAttribute(0, osg::StateAttribute::TEXTURE))
+            osg::StateSet* stateSet = baseComponent->getChild(0)->getOrCreateStateSet();
+
+            if (auto blah = stateSet->getTextureAttribute(0, osg::StateAttribute::TEXTURE))
             {
                 if (osg::ref_ptr<osg::Texture2D> texture = dynamic_cast<osg::Texture2D*>(blah); texture != nullptr)
                 {
-                    if (tiled)
-                    {
-                        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-                        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
-                    }
-                    else
+                    // the texture is shared with every other widget using the same image so swap it rather than changing its wrap
+                    if (auto replacement = TextureCache::instance().texture(texture->getImage(), tiled ? TextureCache::Wrap::Repeat : TextureCache::Wrap::Clamp))
                     {
-                        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP);
-                        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP);
+                        stateSet->setTextureAttributeAndModes(0, replacement, osg::StateAttribute::ON);
                     }
                 }
                 else spdlog::get("log")->error("failed to retrieve texture on gui object {}", getName());
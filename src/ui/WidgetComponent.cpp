@@ -1,6 +1,7 @@
 
 #include "WidgetComponent.hpp"
 #include "Widget.hpp"
+#include "osg/TextureCache.hpp"
 
 #include <osg/Texture2D>
 #include <osgDB/ReadFile>
@@ -11,9 +12,7 @@ namespace ehb
     {
         if (auto geometry = osg::createTexturedQuadGeometry(osg::Vec3(), osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0)))
         {
-            osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
-            texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-            texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
+            osg::ref_ptr<osg::Texture2D> texture = TextureCache::instance().texture(image, TextureCache::Wrap::Repeat);
 
             geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
 
@@ -44,7 +43,7 @@ namespace ehb
 
     CornerComponent::CornerComponent(Corner corner, osg::Image* image) : corner(corner), width(image->s()), height(image->t())
     {
-        osg::Texture2D* texture = new osg::Texture2D(image);
+        osg::ref_ptr<osg::Texture2D> texture = TextureCache::instance().texture(image, TextureCache::Wrap::Clamp);
 
         auto geometry = osg::createTexturedQuadGeometry(osg::Vec3(), osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
         geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
@@ -107,9 +106,7 @@ namespace ehb
 
     SideComponent::SideComponent(Side side, osg::Image* image, uint32_t border) : side(side), border(border), width(image->s()), height(image->t())
     {
-        osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
-        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
+        osg::ref_ptr<osg::Texture2D> texture = TextureCache::instance().texture(image, TextureCache::Wrap::Repeat);
 
         osg::ref_ptr<osg::Geometry> geometry = osg::createTexturedQuadGeometry(osg::Vec3(0, 0, 0), osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
         geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
@@ -0,0 +1,592 @@
+
+#include "NavGraph.hpp"
+
+#include "Parallel.hpp"
+#include "Region.hpp"
+#include "osg/SiegeNodeMesh.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+namespace ehb
+{
+    namespace
+    {
+        //! how far apart two logical node boxes can be and still count as touching
+        constexpr float touchDistance = 0.25f;
+
+        //! how far from a door the logical nodes it joins can be
+        constexpr float doorReach = 2.0f;
+
+        uint64_t logicalKey(uint32_t guid, uint8_t id)
+        {
+            return (static_cast<uint64_t>(guid) << 8) | id;
+        }
+
+        //! whether a and b are within touchDistance of each other, portal is then the middle of where they meet
+        bool touching(const osg::BoundingBox& a, const osg::BoundingBox& b, osg::Vec3& portal)
+        {
+            osg::Vec3 min, max;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                min[axis] = std::max(a._min[axis], b._min[axis]) - touchDistance;
+                max[axis] = std::min(a._max[axis], b._max[axis]) + touchDistance;
+
+                if (min[axis] > max[axis]) return false;
+            }
+
+            portal = (min + max) * 0.5f;
+
+            return true;
+        }
+
+        float distanceToBox(const osg::BoundingBox& box, const osg::Vec3& point)
+        {
+            osg::Vec3 closest;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                closest[axis] = std::clamp(point[axis], box._min[axis], box._max[axis]);
+            }
+
+            return (point - closest).length();
+        }
+
+        //! both directions of every connection, with where the sides meet
+        struct Connection final
+        {
+            uint32_t from, to;
+            osg::Vec3 portal;
+        };
+
+        /*
+         * packs connections into edges grouped by the node they leave from, costing the distance between the node centers.
+         * a pair of nodes only keeps the first connection found between them
+         */
+        template <typename Node, typename Edge, typename Center>
+        void pack(std::vector<Connection>& connections, std::vector<Node>& nodes, std::vector<Edge>& edges, Center center)
+        {
+            std::stable_sort(connections.begin(), connections.end(), [](const Connection& lhs, const Connection& rhs)
+                {
+                    return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+                });
+
+            const auto sameNodes = [](const Connection& lhs, const Connection& rhs) { return lhs.from == rhs.from && lhs.to == rhs.to; };
+
+            connections.erase(std::unique(connections.begin(), connections.end(), sameNodes), connections.end());
+
+            edges.clear();
+            edges.reserve(connections.size());
+
+            for (Node& node : nodes)
+            {
+                node.firstEdge = node.edgeCount = 0;
+            }
+
+            for (const Connection& connection : connections)
+            {
+                Node& node = nodes[connection.from];
+
+                if (node.edgeCount == 0) node.firstEdge = static_cast<uint32_t>(edges.size());
+
+                node.edgeCount++;
+
+                Edge& edge = edges.emplace_back();
+
+                edge.to = connection.to;
+                edge.cost = (center(nodes[connection.to]) - center(node)).length();
+                edge.portal = connection.portal;
+            }
+        }
+    }
+
+    struct NavGraph::SearchState final
+    {
+        uint32_t stamp = 0;
+
+        std::vector<uint32_t> seen;         //!< the stamp of the last search to reach each node
+        std::vector<uint32_t> done;         //!< the stamp of the last search to finish with each node
+        std::vector<uint32_t> marked;       //!< free for the caller, reset along with the stamps
+        std::vector<float> cost;
+        std::vector<uint32_t> parent;
+
+        //! estimated total cost and node, kept as a heap with the cheapest first
+        std::vector<std::pair<float, uint32_t>> open;
+
+        void begin(size_t size)
+        {
+            if (seen.size() < size)
+            {
+                seen.resize(size, 0);
+                done.resize(size, 0);
+                marked.resize(size, 0);
+                cost.resize(size);
+                parent.resize(size);
+            }
+
+            // stamps only go stale once they wrap around
+            if (++stamp == 0)
+            {
+                std::fill(seen.begin(), seen.end(), 0);
+                std::fill(done.begin(), done.end(), 0);
+                std::fill(marked.begin(), marked.end(), 0);
+
+                stamp = 1;
+            }
+
+            open.clear();
+        }
+    };
+
+    struct NavGraph::Workspace final
+    {
+        SearchState siege;
+        SearchState logical;
+    };
+
+    std::unique_ptr<NavGraph::Workspace> NavGraph::acquireWorkspace() const
+    {
+        std::lock_guard<std::mutex> lock(workspaceMutex);
+
+        if (workspaces.empty()) return std::make_unique<Workspace>();
+
+        std::unique_ptr<Workspace> result = std::move(workspaces.back());
+        workspaces.pop_back();
+
+        return result;
+    }
+
+    void NavGraph::releaseWorkspace(std::unique_ptr<Workspace> work) const
+    {
+        std::lock_guard<std::mutex> lock(workspaceMutex);
+
+        workspaces.push_back(std::move(work));
+    }
+
+    NavGraph::~NavGraph() = default;
+
+    NavGraph::NavGraph(const Region& region, size_t cacheSize) : region(&region), cacheSize(cacheSize)
+    {
+        // nodes are taken in guid order so the same region always comes out as the same graph
+        std::vector<uint32_t> guids;
+        guids.reserve(region.nodeMap.size());
+
+        for (const auto& entry : region.nodeMap)
+        {
+            guids.push_back(entry.first);
+        }
+
+        std::sort(guids.begin(), guids.end());
+
+        std::unordered_map<uint32_t, uint32_t> siegeIndex;
+        std::vector<const SiegeNodeMesh*> meshes;
+        std::vector<std::pair<uint32_t, uint32_t>> logicalRanges; //!< first and one past the last logical node of each siege node
+        std::vector<const SiegeNodeMesh::LogicalNodeGrouping*> groupings;
+
+        for (const uint32_t guid : guids)
+        {
+            const osg::MatrixTransform* xform = region.nodeMap.at(guid).get();
+
+            if (xform->getNumChildren() == 0) continue;
+
+            const SiegeNodeMesh* mesh = dynamic_cast<const SiegeNodeMesh*>(xform->getChild(0));
+
+            if (mesh == nullptr) continue;
+
+            SiegeNode node;
+
+            node.guid = guid;
+            node.matrix = xform->getMatrix();
+
+            const uint32_t index = static_cast<uint32_t>(siegeNodes.size());
+            const uint32_t firstLogical = static_cast<uint32_t>(logicalNodes.size());
+
+            for (const auto& grouping : mesh->logicalNodeGroupings)
+            {
+                if (!SiegeNodeMesh::walkable(grouping.flag) || !grouping.bbox.valid()) continue;
+
+                LogicalNode& logical = logicalNodes.emplace_back();
+
+                logical.siegeNode = index;
+                logical.id = grouping.id;
+
+                for (unsigned int i = 0; i < 8; ++i)
+                {
+                    logical.bounds.expandBy(grouping.bbox.corner(i) * node.matrix);
+                }
+
+                node.bounds.expandBy(logical.bounds);
+
+                logicalIndex.emplace(logicalKey(guid, grouping.id), static_cast<uint32_t>(logicalNodes.size() - 1));
+                groupings.push_back(&grouping);
+            }
+
+            // a node without anything to walk on is never part of a path
+            if (!node.bounds.valid()) continue;
+
+            siegeIndex.emplace(guid, index);
+            siegeNodes.push_back(node);
+            meshes.push_back(mesh);
+            logicalRanges.emplace_back(firstLogical, static_cast<uint32_t>(logicalNodes.size()));
+        }
+
+        std::vector<Connection> connections, doorConnections;
+
+        const auto connect = [&connections](uint32_t a, uint32_t b, const osg::Vec3& portal)
+        {
+            connections.push_back(Connection{ a, b, portal });
+            connections.push_back(Connection{ b, a, portal });
+        };
+
+        // logical nodes of the same mesh
+        for (uint32_t index = 0; index < siegeNodes.size(); ++index)
+        {
+            const auto [first, last] = logicalRanges[index];
+
+            bool stored = false;
+
+            for (uint32_t i = first; i < last; ++i)
+            {
+                for (const auto& leafConnection : groupings[i]->leafConnections)
+                {
+                    stored = true;
+
+                    // connections to logical nodes that can't be walked on aren't in the index
+                    const auto itr = logicalIndex.find(logicalKey(siegeNodes[index].guid, leafConnection.farId));
+
+                    if (itr == logicalIndex.end() || itr->second == i) continue;
+
+                    osg::Vec3 portal;
+
+                    if (!touching(logicalNodes[i].bounds, logicalNodes[itr->second].bounds, portal))
+                    {
+                        portal = (center(logicalNodes[i]) + center(logicalNodes[itr->second])) * 0.5f;
+                    }
+
+                    connect(i, itr->second, portal);
+                }
+            }
+
+            // meshes that don't store any connections fall back to joining the logical nodes that touch
+            if (!stored)
+            {
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    for (uint32_t j = i + 1; j < last; ++j)
+                    {
+                        if (osg::Vec3 portal; touching(logicalNodes[i].bounds, logicalNodes[j].bounds, portal)) connect(i, j, portal);
+                    }
+                }
+            }
+        }
+
+        // logical nodes on either side of each door
+        for (const Region::DoorLink& link : region.doorLinks)
+        {
+            const auto itr = siegeIndex.find(link.guid), farItr = siegeIndex.find(link.farGuid);
+
+            if (itr == siegeIndex.end() || farItr == siegeIndex.end()) continue;
+
+            const uint32_t a = itr->second, b = farItr->second;
+
+            const osg::Vec3 door = osg::Vec3(meshes[a]->getMatrixForDoorId(link.door).getTrans()) * siegeNodes[a].matrix;
+
+            doorConnections.push_back(Connection{ a, b, door });
+            doorConnections.push_back(Connection{ b, a, door });
+
+            const auto [first, last] = logicalRanges[a];
+            const auto [farFirst, farLast] = logicalRanges[b];
+
+            bool joined = false;
+
+            for (uint32_t i = first; i < last; ++i)
+            {
+                if (distanceToBox(logicalNodes[i].bounds, door) > doorReach) continue;
+
+                for (uint32_t j = farFirst; j < farLast; ++j)
+                {
+                    if (distanceToBox(logicalNodes[j].bounds, door) > doorReach) continue;
+
+                    if (osg::Vec3 portal; touching(logicalNodes[i].bounds, logicalNodes[j].bounds, portal))
+                    {
+                        connect(i, j, portal);
+
+                        joined = true;
+                    }
+                }
+            }
+
+            // boxes a little further apart than touchDistance still meet at the door, join whichever are closest to it
+            if (!joined)
+            {
+                const auto closest = [this, &door](uint32_t begin, uint32_t end)
+                {
+                    uint32_t result = none;
+                    float best = doorReach;
+
+                    for (uint32_t i = begin; i < end; ++i)
+                    {
+                        if (const float distance = distanceToBox(logicalNodes[i].bounds, door); distance <= best)
+                        {
+                            result = i;
+                            best = distance;
+                        }
+                    }
+
+                    return result;
+                };
+
+                const uint32_t i = closest(first, last), j = closest(farFirst, farLast);
+
+                if (i != none && j != none) connect(i, j, door);
+            }
+        }
+
+        pack(connections, logicalNodes, logicalEdges, [](const LogicalNode& node) { return center(node); });
+        pack(doorConnections, siegeNodes, siegeEdges, [](const SiegeNode& node) { return center(node); });
+    }
+
+    NavGraph::Path NavGraph::findPath(const osg::Vec3& start, const osg::Vec3& goal) const
+    {
+        Path result;
+
+        osg::Vec3 startFloor, goalFloor;
+
+        const uint32_t from = locate(start, startFloor), to = locate(goal, goalFloor);
+
+        if (from == none || to == none) return result;
+
+        std::vector<uint32_t> nodes;
+
+        if (!route(from, to, nodes)) return result;
+
+        result.found = true;
+        result.steps.reserve(nodes.size());
+        result.waypoints.reserve(nodes.size() + 1);
+        result.waypoints.push_back(startFloor);
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            const LogicalNode& node = logicalNodes[nodes[i]];
+
+            result.steps.push_back(Step{ siegeNodes[node.siegeNode].guid, node.id });
+
+            if (i + 1 < nodes.size())
+            {
+                if (const Edge* edge = findEdge(nodes[i], nodes[i + 1])) result.waypoints.push_back(edge->portal);
+            }
+        }
+
+        result.waypoints.push_back(goalFloor);
+
+        for (size_t i = 1; i < result.waypoints.size(); ++i)
+        {
+            result.length += (result.waypoints[i] - result.waypoints[i - 1]).length();
+        }
+
+        return result;
+    }
+
+    std::vector<NavGraph::Path> NavGraph::findPaths(const std::vector<Query>& queries, unsigned int threadCount) const
+    {
+        std::vector<Path> result(queries.size());
+
+        parallelFor(queries.size(), [this, &queries, &result](size_t i)
+            {
+                result[i] = findPath(queries[i].start, queries[i].goal);
+            }, threadCount);
+
+        return result;
+    }
+
+    NavGraph::Stats NavGraph::stats() const
+    {
+        Stats result;
+
+        result.siegeNodes = siegeNodes.size();
+        result.logicalNodes = logicalNodes.size();
+        result.doorEdges = siegeEdges.size();
+        result.logicalEdges = logicalEdges.size();
+        result.searches = searches;
+        result.cacheHits = cacheHits;
+
+        return result;
+    }
+
+    template <typename Node, typename Allowed>
+    bool NavGraph::search(const std::vector<Node>& nodes, const std::vector<Edge>& edges, uint32_t start, uint32_t goal, Allowed allowed, SearchState& state)
+    {
+        state.begin(nodes.size());
+
+        // straight line distance never overestimates since every edge costs at least that much
+        const osg::Vec3 target = center(nodes[goal]);
+
+        const auto push = [&nodes, &state, &target](uint32_t index, float cost, uint32_t parent)
+        {
+            state.seen[index] = state.stamp;
+            state.cost[index] = cost;
+            state.parent[index] = parent;
+
+            state.open.emplace_back(cost + (center(nodes[index]) - target).length(), index);
+            std::push_heap(state.open.begin(), state.open.end(), std::greater<>());
+        };
+
+        push(start, 0, none);
+
+        while (!state.open.empty())
+        {
+            std::pop_heap(state.open.begin(), state.open.end(), std::greater<>());
+
+            const uint32_t index = state.open.back().second;
+
+            state.open.pop_back();
+
+            // a node can be in the heap more than once when a cheaper way to it turned up, only the first one counts
+            if (state.done[index] == state.stamp) continue;
+
+            state.done[index] = state.stamp;
+
+            if (index == goal) return true;
+
+            const Node& node = nodes[index];
+
+            for (uint32_t i = node.firstEdge; i < node.firstEdge + node.edgeCount; ++i)
+            {
+                const Edge& edge = edges[i];
+
+                if (state.done[edge.to] == state.stamp || !allowed(edge.to)) continue;
+
+                const float cost = state.cost[index] + edge.cost;
+
+                if (state.seen[edge.to] != state.stamp || cost < state.cost[edge.to]) push(edge.to, cost, index);
+            }
+        }
+
+        return false;
+    }
+
+    osg::Vec3 NavGraph::center(const SiegeNode& node)
+    {
+        return node.bounds.center();
+    }
+
+    osg::Vec3 NavGraph::center(const LogicalNode& node)
+    {
+        return node.bounds.center();
+    }
+
+    uint32_t NavGraph::locate(const osg::Vec3& point, osg::Vec3& floor) const
+    {
+        Region::SurfaceHit hit;
+
+        // lifted a little so a point resting on the floor, or just under it from rounding, still lands on it
+        if (!region->heightAt(point + osg::Vec3(0, 0.5f, 0), hit)) return none;
+
+        const auto itr = logicalIndex.find(logicalKey(hit.guid, hit.logicalNode));
+
+        if (itr == logicalIndex.end()) return none;
+
+        floor = hit.position * siegeNodes[logicalNodes[itr->second].siegeNode].matrix;
+
+        return itr->second;
+    }
+
+    bool NavGraph::route(uint32_t start, uint32_t goal, std::vector<uint32_t>& result) const
+    {
+        const uint64_t key = (static_cast<uint64_t>(start) << 32) | goal;
+
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+
+            if (const auto itr = cacheIndex.find(key); itr != cacheIndex.end())
+            {
+                cache.splice(cache.begin(), cache, itr->second);
+                result = itr->second->second;
+
+                cacheHits++;
+
+                return !result.empty();
+            }
+        }
+
+        // searching happens outside of the lock so paths asked for on other threads aren't held up behind it
+        searches++;
+
+        result.clear();
+
+        if (start == goal)
+        {
+            result.push_back(start);
+        }
+        else
+        {
+            std::unique_ptr<Workspace> borrowed = acquireWorkspace();
+            Workspace& work = *borrowed;
+
+            const uint32_t startNode = logicalNodes[start].siegeNode, goalNode = logicalNodes[goal].siegeNode;
+            const auto anywhere = [](uint32_t) { return true; };
+
+            bool found = false;
+
+            if (search(siegeNodes, siegeEdges, startNode, goalNode, anywhere, work.siege))
+            {
+                SearchState& siege = work.siege;
+
+                for (uint32_t i = goalNode; i != none; i = siege.parent[i])
+                {
+                    siege.marked[i] = siege.stamp;
+                }
+
+                const auto inCorridor = [this, &siege](uint32_t index) { return siege.marked[logicalNodes[index].siegeNode] == siege.stamp; };
+
+                found = search(logicalNodes, logicalEdges, start, goal, inCorridor, work.logical);
+            }
+
+            // the way through can leave the corridor, say when a node is split in two by a wall, so look everywhere else
+            if (!found) found = search(logicalNodes, logicalEdges, start, goal, anywhere, work.logical);
+
+            if (found)
+            {
+                for (uint32_t i = goal; i != none; i = work.logical.parent[i])
+                {
+                    result.push_back(i);
+                }
+
+                std::reverse(result.begin(), result.end());
+            }
+
+            releaseWorkspace(std::move(borrowed));
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        // another thread may have searched for the same path in the meantime
+        if (cacheSize != 0 && cacheIndex.count(key) == 0)
+        {
+            cache.emplace_front(key, result);
+            cacheIndex.emplace(key, cache.begin());
+
+            if (cache.size() > cacheSize)
+            {
+                cacheIndex.erase(cache.back().first);
+                cache.pop_back();
+            }
+        }
+
+        return !result.empty();
+    }
+
+    const NavGraph::Edge* NavGraph::findEdge(uint32_t from, uint32_t to) const
+    {
+        const LogicalNode& node = logicalNodes[from];
+
+        for (uint32_t i = node.firstEdge; i < node.firstEdge + node.edgeCount; ++i)
+        {
+            if (logicalEdges[i].to == to) return &logicalEdges[i];
+        }
+
+        return nullptr;
+    }
+}
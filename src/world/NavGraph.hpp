@@ -0,0 +1,163 @@
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <osg/BoundingBox>
+#include <osg/Matrix>
+#include <osg/ref_ptr>
+
+namespace ehb
+{
+    class Region;
+
+    /*
+     * where actors can walk in a region, as a graph of the floor and water logical nodes of every placed node
+     *
+     * logical nodes in the same mesh are joined by the connections stored in the sno file, logical nodes on either side
+     * of a door are joined when they meet at it. the siege nodes and their doors form a second, coarser graph that is
+     * searched first so the logical node search only has to look along the corridor of nodes it found
+     *
+     * the graph is a snapshot of the region when it was built, build a new one if nodes are added or moved. everything
+     * here only reads the graph so paths can be asked for from any number of threads at once
+     */
+    class NavGraph final
+    {
+    public:
+
+        //! a logical node of a placed siege node
+        struct Step final
+        {
+            uint32_t guid = 0;
+            uint8_t logicalNode = 0;
+        };
+
+        struct Path final
+        {
+            bool found = false;
+            std::vector<Step> steps;            //!< start to goal
+            std::vector<osg::Vec3> waypoints;   //!< the start, where each step is left for the next one and the goal
+            float length = 0;                   //!< along the waypoints
+        };
+
+        struct Query final
+        {
+            osg::Vec3 start;
+            osg::Vec3 goal;
+        };
+
+        struct Stats final
+        {
+            size_t siegeNodes = 0;
+            size_t logicalNodes = 0;
+            size_t doorEdges = 0;           //!< siege node to siege node
+            size_t logicalEdges = 0;        //!< both directions of every connection, in and between siege nodes
+            size_t searches = 0;            //!< paths searched for rather than taken from the cache
+            size_t cacheHits = 0;
+        };
+
+        //! @param cacheSize how many of the most recently searched paths are kept around
+        explicit NavGraph(const Region& region, size_t cacheSize = 1024);
+
+        ~NavGraph();
+
+        /*
+         * a path over the floor between two points in the space of the region, each point is dropped onto the closest
+         * floor or water face at or below it
+         */
+        Path findPath(const osg::Vec3& start, const osg::Vec3& goal) const;
+
+        //! every query is answered in order, split across threadCount threads or every core when 0
+        std::vector<Path> findPaths(const std::vector<Query>& queries, unsigned int threadCount = 0) const;
+
+        Stats stats() const;
+
+    private:
+
+        static constexpr uint32_t none = 0xffffffff;
+
+        struct Edge final
+        {
+            uint32_t to = 0;
+            float cost = 0;
+            osg::Vec3 portal;               //!< where the two sides meet, in the space of the region
+        };
+
+        struct SiegeNode final
+        {
+            uint32_t guid = 0;
+            osg::Matrix matrix;             //!< from the space of the node to the space of the region
+            osg::BoundingBox bounds;        //!< its logical nodes, in the space of the region
+            uint32_t firstEdge = 0, edgeCount = 0;
+        };
+
+        struct LogicalNode final
+        {
+            uint32_t siegeNode = 0;         //!< index into siegeNodes
+            uint8_t id = 0;
+            osg::BoundingBox bounds;        //!< in the space of the region
+            uint32_t firstEdge = 0, edgeCount = 0;
+        };
+
+        //! search state for one level of the graph
+        struct SearchState;
+        struct Workspace;
+
+        /*
+         * a search borrows a workspace for as long as it runs and hands it back after, they belong to the graph rather than
+         * to any thread so searches don't allocate once warmed up however many batches of paths are asked for
+         */
+        std::unique_ptr<Workspace> acquireWorkspace() const;
+        void releaseWorkspace(std::unique_ptr<Workspace> work) const;
+
+        //! a* from start to goal only through nodes allowed says yes to, the path is left in the parents of state
+        template <typename Node, typename Allowed>
+        static bool search(const std::vector<Node>& nodes, const std::vector<Edge>& edges, uint32_t start, uint32_t goal, Allowed allowed, SearchState& state);
+
+        static osg::Vec3 center(const SiegeNode& node);
+        static osg::Vec3 center(const LogicalNode& node);
+
+        /*
+         * the logical node under point or none
+         *
+         * @param floor where point lands on it, in the space of the region
+         */
+        uint32_t locate(const osg::Vec3& point, osg::Vec3& floor) const;
+
+        //! the logical nodes from start to goal, from the cache if they were searched for recently
+        bool route(uint32_t start, uint32_t goal, std::vector<uint32_t>& result) const;
+
+        const Edge* findEdge(uint32_t from, uint32_t to) const;
+
+    private:
+
+        osg::ref_ptr<const Region> region;
+
+        std::vector<SiegeNode> siegeNodes;
+        std::vector<Edge> siegeEdges;
+
+        std::vector<LogicalNode> logicalNodes;
+        std::vector<Edge> logicalEdges;
+
+        //! keyed by guid and logical node id
+        std::unordered_map<uint64_t, uint32_t> logicalIndex;
+
+        //! most recent at the front, keyed by the start and goal logical nodes
+        using CacheEntry = std::pair<uint64_t, std::vector<uint32_t>>;
+
+        const size_t cacheSize;
+        mutable std::list<CacheEntry> cache;
+        mutable std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cacheIndex;
+        mutable std::mutex cacheMutex;
+
+        //! the workspaces not in use, there are only ever as many as searches that have run at once
+        mutable std::vector<std::unique_ptr<Workspace>> workspaces;
+        mutable std::mutex workspaceMutex;
+
+        mutable std::atomic<size_t> searches{ 0 }, cacheHits{ 0 };
+    };
+}
@@ -1,8 +1,218 @@
 
 #include "Region.hpp"
 
+#include "osg/SiegeNodeMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_set>
+#include <osg/Geometry>
+
 namespace ehb
 {
+    //! culls a node drawable whenever the region it is being drawn under has it in a batch
+    class Region::BatchedCullCallback final : public osg::DrawableCullCallback
+    {
+    public:
+
+        virtual bool cull(osg::NodeVisitor* nv, osg::Drawable* drawable, osg::RenderInfo* renderInfo) const override
+        {
+            const osg::NodePath& nodePath = nv->getNodePath();
+
+            for (auto itr = nodePath.rbegin(); itr != nodePath.rend(); ++itr)
+            {
+                if (const Region* region = dynamic_cast<const Region*>(*itr))
+                {
+                    return region->batches != nullptr;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    namespace
+    {
+        //! arrays set without a binding are drawn per vertex
+        bool perVertex(const osg::Array* array)
+        {
+            return array == nullptr || array->getBinding() == osg::Array::BIND_PER_VERTEX || array->getBinding() == osg::Array::BIND_UNDEFINED;
+        }
+
+        //! only per vertex triangle lists with normals the batching pass knows how to rotate can be merged
+        bool batchable(const osg::Geometry& geometry)
+        {
+            if (dynamic_cast<const osg::Vec3Array*>(geometry.getVertexArray()) == nullptr) return false;
+
+            if (const osg::Array* normals = geometry.getNormalArray())
+            {
+                if (normals->getType() != osg::Array::Vec3ArrayType && normals->getType() != osg::Array::Vec3sArrayType) return false;
+            }
+
+            if (!perVertex(geometry.getNormalArray()) || !perVertex(geometry.getColorArray())) return false;
+
+            if (geometry.getNumVertexAttribArrays() != 0 || geometry.getNumPrimitiveSets() == 0) return false;
+
+            for (unsigned int i = 0; i < geometry.getNumPrimitiveSets(); ++i)
+            {
+                const osg::PrimitiveSet* primitiveSet = geometry.getPrimitiveSet(i);
+
+                if (primitiveSet->getDrawElements() == nullptr || primitiveSet->getMode() != GL_TRIANGLES) return false;
+            }
+
+            return true;
+        }
+
+        /*
+         * drawables can only share a batch when they share a state set and their arrays are laid out the same way, texture
+         * units are recorded by the first unit using the same array so units sharing coordinates still do in the batch
+         */
+        using BatchKey = std::pair<const osg::StateSet*, std::vector<int>>;
+
+        BatchKey batchKey(const osg::Geometry& geometry)
+        {
+            BatchKey result(geometry.getStateSet(), {});
+
+            const auto add = [&result](const osg::Array* array)
+            {
+                if (array == nullptr)
+                {
+                    result.second.push_back(-1);
+                }
+                else
+                {
+                    result.second.push_back(array->getType());
+                    result.second.push_back(static_cast<int>(array->getDataType()));
+                    result.second.push_back(array->getNormalize());
+                }
+            };
+
+            add(geometry.getNormalArray());
+            add(geometry.getColorArray());
+
+            for (unsigned int unit = 0; unit < geometry.getNumTexCoordArrays(); ++unit)
+            {
+                const osg::Array* array = geometry.getTexCoordArray(unit);
+
+                unsigned int first = 0;
+
+                while (geometry.getTexCoordArray(first) != array) first++;
+
+                add(array);
+
+                result.second.push_back(static_cast<int>(first));
+            }
+
+            return result;
+        }
+
+        //! one node drawable in a batch, the vertices it uses are copied in the order they are first indexed
+        struct BatchPart
+        {
+            const osg::Geometry* geometry;
+            osg::Matrix matrix;
+            std::vector<uint32_t> used;
+        };
+
+        struct Batch
+        {
+            std::vector<BatchPart> parts;
+            std::vector<uint32_t> indices;
+            uint32_t vertexCount = 0;
+        };
+
+        //! a new array of the same kind as the ones get returns for each part, holding the vertices each part uses
+        template <typename Get>
+        osg::ref_ptr<osg::Array> gatherArray(const Batch& batch, Get get)
+        {
+            const osg::Array* first = get(*batch.parts.front().geometry);
+
+            osg::ref_ptr<osg::Array> result = static_cast<osg::Array*>(first->cloneType());
+
+            result->setBinding(first->getBinding());
+            result->setNormalize(first->getNormalize());
+            result->resizeArray(batch.vertexCount);
+
+            const size_t size = first->getElementSize();
+
+            // osg only hands out the data of an array as const, this one was made above and nothing else has it yet
+            uint8_t* out = static_cast<uint8_t*>(const_cast<GLvoid*>(result->getDataPointer()));
+
+            for (const BatchPart& part : batch.parts)
+            {
+                const uint8_t* in = static_cast<const uint8_t*>(get(*part.geometry)->getDataPointer());
+
+                for (uint32_t index : part.used)
+                {
+                    std::memcpy(out, in + index * size, size);
+
+                    out += size;
+                }
+            }
+
+            return result;
+        }
+
+        //! rotates the normals into region space keeping whichever layout the mesh was read with
+        osg::ref_ptr<osg::Array> gatherNormals(const Batch& batch)
+        {
+            const osg::Array* first = batch.parts.front().geometry->getNormalArray();
+
+            if (first->getType() == osg::Array::Vec3sArrayType)
+            {
+                osg::ref_ptr<osg::Vec3sArray> result = new osg::Vec3sArray;
+
+                result->reserve(batch.vertexCount);
+                result->setNormalize(true);
+
+                const auto pack = [](float value) { return static_cast<short>(std::lround(osg::clampBetween(value, -1.0f, 1.0f) * 32767.0f)); };
+
+                for (const BatchPart& part : batch.parts)
+                {
+                    const osg::Vec3sArray& normals = *static_cast<const osg::Vec3sArray*>(part.geometry->getNormalArray());
+
+                    for (uint32_t index : part.used)
+                    {
+                        const osg::Vec3s& normal = normals[index];
+
+                        osg::Vec3 rotated = osg::Matrix::transform3x3(osg::Vec3(normal.x(), normal.y(), normal.z()) / 32767.0f, part.matrix);
+                        rotated.normalize();
+
+                        result->push_back(osg::Vec3s(pack(rotated.x()), pack(rotated.y()), pack(rotated.z())));
+                    }
+                }
+
+                result->setBinding(osg::Array::BIND_PER_VERTEX);
+
+                return result;
+            }
+
+            osg::ref_ptr<osg::Vec3Array> result = new osg::Vec3Array;
+
+            result->reserve(batch.vertexCount);
+
+            for (const BatchPart& part : batch.parts)
+            {
+                const osg::Vec3Array& normals = *static_cast<const osg::Vec3Array*>(part.geometry->getNormalArray());
+
+                for (uint32_t index : part.used)
+                {
+                    osg::Vec3 rotated = osg::Matrix::transform3x3(normals[index], part.matrix);
+                    rotated.normalize();
+
+                    result->push_back(rotated);
+                }
+            }
+
+            result->setBinding(osg::Array::BIND_PER_VERTEX);
+
+            return result;
+        }
+    }
+
     const osg::MatrixTransform* Region::targetNode() const
     {
         return static_cast<const osg::MatrixTransform*>(getUserDataContainer()->getUserObject(8));
@@ -34,4 +244,524 @@ namespace ehb
 
         return nullptr;
     }
-}
\ No newline at end of file
+
+    void Region::addNode(uint32_t guid, osg::MatrixTransform* xform)
+    {
+        addChild(xform);
+        nodeMap.emplace(guid, xform);
+    }
+
+    void Region::addDoorLink(const DoorLink& link)
+    {
+        doorLinks.push_back(link);
+    }
+
+    Region::PlacementStats Region::placeNodes(uint32_t targetGuid)
+    {
+        PlacementStats stats;
+
+        // every node gets an index so the search only ever touches flat arrays
+        std::unordered_map<uint32_t, uint32_t> indices;
+        std::vector<osg::MatrixTransform*> xforms;
+        std::vector<const SiegeNodeMesh*> meshes;
+
+        indices.reserve(nodeMap.size());
+        xforms.reserve(nodeMap.size());
+        meshes.reserve(nodeMap.size());
+
+        for (const auto& entry : nodeMap)
+        {
+            osg::MatrixTransform* xform = entry.second.get();
+
+            indices.emplace(entry.first, static_cast<uint32_t>(xforms.size()));
+            xforms.push_back(xform);
+            meshes.push_back(xform->getNumChildren() != 0 ? dynamic_cast<const SiegeNodeMesh*>(xform->getChild(0)) : nullptr);
+        }
+
+        const auto start = indices.find(targetGuid);
+
+        if (start == indices.end()) return stats;
+
+        // the doors leaving each node with their matrices already looked up, node i has doors[firstDoor[i]] up to doors[firstDoor[i + 1]]
+        struct Door
+        {
+            uint32_t to;
+            const osg::Matrix* matrix;
+            const osg::Matrix* farMatrix;
+        };
+
+        constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        std::vector<std::pair<uint32_t, uint32_t>> ends;
+        std::vector<uint32_t> firstDoor(xforms.size() + 1, 0);
+
+        ends.reserve(doorLinks.size());
+
+        for (const DoorLink& link : doorLinks)
+        {
+            const auto itr = indices.find(link.guid), farItr = indices.find(link.farGuid);
+
+            if (itr == indices.end() || farItr == indices.end())
+            {
+                ends.emplace_back(none, none);
+                continue;
+            }
+
+            ends.emplace_back(itr->second, farItr->second);
+            firstDoor[itr->second + 1]++;
+        }
+
+        for (size_t i = 1; i < firstDoor.size(); ++i)
+        {
+            firstDoor[i] += firstDoor[i - 1];
+        }
+
+        std::vector<Door> doors(firstDoor.back());
+        std::vector<uint32_t> cursor(firstDoor.begin(), firstDoor.end() - 1);
+
+        for (size_t i = 0; i < doorLinks.size(); ++i)
+        {
+            const auto [from, to] = ends[i];
+
+            if (from == none) continue;
+
+            const SiegeNodeMesh* mesh = meshes[from], * farMesh = meshes[to];
+
+            doors[cursor[from]++] = Door{ to, mesh ? mesh->doorMatrix(doorLinks[i].door) : nullptr, farMesh ? farMesh->doorMatrix(doorLinks[i].farDoor) : nullptr };
+        }
+
+        std::vector<char> placed(xforms.size(), 0);
+        std::vector<uint32_t> queue;
+
+        queue.reserve(xforms.size());
+        queue.push_back(start->second);
+        placed[start->second] = 1;
+
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const uint32_t index = queue[head];
+
+            for (uint32_t i = firstDoor[index]; i < firstDoor[index + 1]; ++i)
+            {
+                const Door& door = doors[i];
+
+                if (placed[door.to]) continue;
+
+                // a node whose door is missing is still visited from where it is so the nodes past it get placed
+                if (door.matrix != nullptr && door.farMatrix != nullptr)
+                {
+                    xforms[door.to]->setMatrix(SiegeNodeMesh::connectMatrix(*door.matrix, *door.farMatrix, xforms[index]->getMatrix()));
+
+                    stats.connections++;
+                }
+                else
+                {
+                    stats.missingDoors++;
+                }
+
+                placed[door.to] = 1;
+                queue.push_back(door.to);
+            }
+        }
+
+        stats.placed = queue.size();
+
+        return stats;
+    }
+
+    bool Region::raycast(const osg::Vec3& start, const osg::Vec3& end, SurfaceHit& hit) const
+    {
+        return cast(start, end, nullptr, surfaceNodes.size(), hit);
+    }
+
+    bool Region::heightAt(const osg::Vec3& point, SurfaceHit& hit) const
+    {
+        if (gridStart.empty() || point.y() < surfaceBox.yMin()) return false;
+
+        const float column = std::floor((point.x() - surfaceBox.xMin()) / gridCellSize);
+        const float row = std::floor((point.z() - surfaceBox.zMin()) / gridCellSize);
+
+        if (column < 0 || row < 0 || column >= gridColumns || row >= gridRows) return false;
+
+        const size_t cell = static_cast<size_t>(row) * gridColumns + static_cast<size_t>(column);
+
+        // every node is tested against the same segment so whichever hit is first along it is the highest
+        const osg::Vec3 end(point.x(), surfaceBox.yMin() - 1.0f, point.z());
+
+        return cast(point, end, gridNodes.data() + gridStart[cell], gridStart[cell + 1] - gridStart[cell], hit);
+    }
+
+    bool Region::cast(const osg::Vec3& start, const osg::Vec3& end, const uint32_t* candidates, size_t count, SurfaceHit& hit) const
+    {
+        const osg::Vec3 direction = end - start;
+
+        bool found = false;
+        float best = 1;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SurfaceNode& node = surfaceNodes[candidates != nullptr ? candidates[i] : i];
+
+            if (!SiegeNodeMesh::segmentHitsBox(node.bounds, start, direction, best)) continue;
+
+            // the matrices are affine so how far along the segment a face is comes out the same in the space of the node
+            SiegeNodeMesh::FaceHit faceHit;
+
+            if (node.mesh->intersect(start * node.inverse, end * node.inverse, faceHit, SiegeNodeMesh::walkableFlags) && (!found || faceHit.ratio < best))
+            {
+                found = true;
+                best = faceHit.ratio;
+
+                hit.guid = node.guid;
+                hit.position = faceHit.position;
+                hit.normal = faceHit.normal;
+                hit.ratio = faceHit.ratio;
+                hit.flag = faceHit.grouping->flag;
+                hit.logicalNode = faceHit.grouping->id;
+            }
+        }
+
+        return found;
+    }
+
+    void Region::buildSurfaceIndex()
+    {
+        surfaceNodes.clear();
+        surfaceBox.init();
+
+        for (const auto& entry : nodeMap)
+        {
+            const osg::MatrixTransform* xform = entry.second.get();
+
+            if (xform->getNumChildren() == 0) continue;
+
+            const SiegeNodeMesh* mesh = dynamic_cast<const SiegeNodeMesh*>(xform->getChild(0));
+
+            if (mesh == nullptr) continue;
+
+            osg::BoundingBox local;
+
+            for (const auto& grouping : mesh->logicalNodeGroupings)
+            {
+                if (SiegeNodeMesh::walkable(grouping.flag)) local.expandBy(grouping.bbox);
+            }
+
+            if (!local.valid()) continue;
+
+            SurfaceNode& node = surfaceNodes.emplace_back();
+
+            for (unsigned int i = 0; i < 8; ++i)
+            {
+                node.bounds.expandBy(local.corner(i) * xform->getMatrix());
+            }
+
+            node.inverse = osg::Matrix::inverse(xform->getMatrix());
+            node.mesh = mesh;
+            node.guid = entry.first;
+
+            surfaceBox.expandBy(node.bounds);
+        }
+
+        // nodes are tested in guid order so the same query always finds the same face when two are equally close
+        std::sort(surfaceNodes.begin(), surfaceNodes.end(), [](const SurfaceNode& lhs, const SurfaceNode& rhs) { return lhs.guid < rhs.guid; });
+
+        gridStart.clear();
+        gridNodes.clear();
+        gridColumns = gridRows = 0;
+
+        if (surfaceNodes.empty()) return;
+
+        // cells about the size of a node, grown for sprawling regions so the grid stays at most 256 cells a side
+        const float width = surfaceBox.xMax() - surfaceBox.xMin(), depth = surfaceBox.zMax() - surfaceBox.zMin();
+
+        gridCellSize = std::max({ 8.0f, width / 256.0f, depth / 256.0f });
+        gridColumns = static_cast<uint32_t>(width / gridCellSize) + 1;
+        gridRows = static_cast<uint32_t>(depth / gridCellSize) + 1;
+
+        const auto cellRange = [this](const osg::BoundingBox& bounds, uint32_t& column0, uint32_t& column1, uint32_t& row0, uint32_t& row1)
+        {
+            column0 = std::min(gridColumns - 1, static_cast<uint32_t>((bounds.xMin() - surfaceBox.xMin()) / gridCellSize));
+            column1 = std::min(gridColumns - 1, static_cast<uint32_t>((bounds.xMax() - surfaceBox.xMin()) / gridCellSize));
+            row0 = std::min(gridRows - 1, static_cast<uint32_t>((bounds.zMin() - surfaceBox.zMin()) / gridCellSize));
+            row1 = std::min(gridRows - 1, static_cast<uint32_t>((bounds.zMax() - surfaceBox.zMin()) / gridCellSize));
+        };
+
+        // counted first so every cell's nodes sit next to each other in one array
+        gridStart.assign(static_cast<size_t>(gridColumns) * gridRows + 1, 0);
+
+        for (const SurfaceNode& node : surfaceNodes)
+        {
+            uint32_t column0, column1, row0, row1; cellRange(node.bounds, column0, column1, row0, row1);
+
+            for (uint32_t row = row0; row <= row1; ++row)
+            {
+                for (uint32_t column = column0; column <= column1; ++column)
+                {
+                    gridStart[static_cast<size_t>(row) * gridColumns + column + 1]++;
+                }
+            }
+        }
+
+        for (size_t i = 1; i < gridStart.size(); ++i)
+        {
+            gridStart[i] += gridStart[i - 1];
+        }
+
+        gridNodes.resize(gridStart.back());
+
+        std::vector<uint32_t> next(gridStart.begin(), gridStart.end() - 1);
+
+        for (uint32_t i = 0; i < surfaceNodes.size(); ++i)
+        {
+            uint32_t column0, column1, row0, row1; cellRange(surfaceNodes[i].bounds, column0, column1, row0, row1);
+
+            for (uint32_t row = row0; row <= row1; ++row)
+            {
+                for (uint32_t column = column0; column <= column1; ++column)
+                {
+                    gridNodes[next[static_cast<size_t>(row) * gridColumns + column]++] = i;
+                }
+            }
+        }
+    }
+
+    void Region::traverse(osg::NodeVisitor& nv)
+    {
+        if (batches == nullptr || nv.getVisitorType() != osg::NodeVisitor::CULL_VISITOR)
+        {
+            osg::MatrixTransform::traverse(nv);
+
+            return;
+        }
+
+        batches->accept(nv);
+
+        // anything a node draws on top of its batched geometry is debug drawing, either added to the mesh or next to it under
+        // the transform of the node. the geometry itself is culled by its callback
+        for (const auto& child : _children)
+        {
+            if (const auto itr = batchedNodes.find(child.get()); itr != batchedNodes.end() && !itr->second->drawingDebugGroups() && child->asGroup()->getNumChildren() == 1)
+            {
+                continue;
+            }
+
+            child->accept(nv);
+        }
+    }
+
+    void Region::resizeGLObjectBuffers(unsigned int maxSize)
+    {
+        osg::MatrixTransform::resizeGLObjectBuffers(maxSize);
+
+        if (batches != nullptr) batches->resizeGLObjectBuffers(maxSize);
+    }
+
+    void Region::releaseGLObjects(osg::State* state) const
+    {
+        osg::MatrixTransform::releaseGLObjects(state);
+
+        if (batches != nullptr) batches->releaseGLObjects(state);
+    }
+
+    osg::DrawableCullCallback* Region::batchedCullCallback()
+    {
+        static osg::ref_ptr<osg::DrawableCullCallback> callback = new Region::BatchedCullCallback;
+
+        return callback.get();
+    }
+
+    void Region::prepareForBatching(SiegeNodeMesh& mesh)
+    {
+        for (unsigned int i = 0; i < mesh.getNumChildren(); ++i)
+        {
+            if (osg::Geometry* geometry = mesh.getChild(i)->asGeometry(); geometry != nullptr && batchable(*geometry))
+            {
+                geometry->setCullCallback(batchedCullCallback());
+            }
+        }
+    }
+
+    Region::BatchStats Region::buildDrawBatches()
+    {
+        const osg::Callback* callback = batchedCullCallback();
+
+        BatchStats stats;
+
+        std::map<BatchKey, size_t> batchIndex;
+        std::vector<Batch> batchList;
+
+        batches = nullptr;
+        batchedNodes.clear();
+
+        for (unsigned int i = 0; i < getNumChildren(); ++i)
+        {
+            osg::Transform* transform = getChild(i)->asTransform();
+            osg::MatrixTransform* xform = transform != nullptr ? transform->asMatrixTransform() : nullptr;
+
+            if (xform == nullptr || xform->getNumChildren() == 0) continue;
+
+            const SiegeNodeMesh* mesh = dynamic_cast<const SiegeNodeMesh*>(xform->getChild(0));
+
+            if (mesh == nullptr) continue;
+
+            bool whole = true;
+
+            for (unsigned int j = 0; j < mesh->getNumChildren(); ++j)
+            {
+                const osg::Geometry* geometry = mesh->getChild(j)->asGeometry();
+
+                if (geometry == nullptr) continue;
+
+                if (geometry->getCullCallback() != callback)
+                {
+                    whole = false;
+
+                    continue;
+                }
+
+                const auto itr = batchIndex.emplace(batchKey(*geometry), batchList.size());
+
+                if (itr.second) batchList.emplace_back();
+
+                Batch& batch = batchList[itr.first->second];
+                BatchPart& part = batch.parts.emplace_back(BatchPart{ geometry, xform->getMatrix() });
+
+                // each vertex the drawable indexes is copied once and its indices are moved to where the copy ends up
+                const unsigned int vertexCount = geometry->getVertexArray()->getNumElements();
+                std::vector<uint32_t> remap(vertexCount, std::numeric_limits<uint32_t>::max());
+
+                for (unsigned int k = 0; k < geometry->getNumPrimitiveSets(); ++k)
+                {
+                    const osg::DrawElements* elements = geometry->getPrimitiveSet(k)->getDrawElements();
+
+                    for (unsigned int l = 0; l < elements->getNumIndices(); ++l)
+                    {
+                        const unsigned int index = elements->index(l);
+
+                        if (index >= vertexCount) continue;
+
+                        if (remap[index] == std::numeric_limits<uint32_t>::max())
+                        {
+                            remap[index] = batch.vertexCount++;
+
+                            part.used.push_back(index);
+                        }
+
+                        batch.indices.push_back(remap[index]);
+                    }
+                }
+
+                stats.drawables++;
+            }
+
+            if (whole) batchedNodes.emplace(xform, mesh);
+        }
+
+        if (batchList.empty())
+        {
+            batchedNodes.clear();
+
+            return stats;
+        }
+
+        batches = new osg::Group;
+
+        std::unordered_set<const osg::BufferData*> counted;
+
+        for (const Batch& batch : batchList)
+        {
+            if (batch.vertexCount == 0) continue;
+
+            const osg::Geometry& first = *batch.parts.front().geometry;
+
+            osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+
+            geometry->setName(first.getName());
+            geometry->setStateSet(const_cast<osg::StateSet*>(first.getStateSet()));
+            geometry->setDataVariance(osg::Object::STATIC);
+
+            osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+
+            vertices->reserve(batch.vertexCount);
+
+            for (const BatchPart& part : batch.parts)
+            {
+                const osg::Vec3Array& positions = *static_cast<const osg::Vec3Array*>(part.geometry->getVertexArray());
+
+                for (uint32_t index : part.used)
+                {
+                    vertices->push_back(positions[index] * part.matrix);
+                }
+            }
+
+            geometry->setVertexArray(vertices.get());
+
+            if (first.getNormalArray() != nullptr)
+            {
+                geometry->setNormalArray(gatherNormals(batch).get());
+            }
+
+            if (first.getColorArray() != nullptr)
+            {
+                geometry->setColorArray(gatherArray(batch, [](const osg::Geometry& part) { return part.getColorArray(); }).get());
+            }
+
+            for (unsigned int unit = 0; unit < first.getNumTexCoordArrays(); ++unit)
+            {
+                const osg::Array* array = first.getTexCoordArray(unit);
+
+                if (array == nullptr) continue;
+
+                unsigned int shared = 0;
+
+                while (first.getTexCoordArray(shared) != array) shared++;
+
+                if (shared != unit)
+                {
+                    geometry->setTexCoordArray(unit, geometry->getTexCoordArray(shared));
+                }
+                else
+                {
+                    geometry->setTexCoordArray(unit, gatherArray(batch, [unit](const osg::Geometry& part) { return part.getTexCoordArray(unit); }).get());
+                }
+            }
+
+            // a region easily has more than 65536 vertices for a common texture so the wider indices are used when needed
+            osg::ref_ptr<osg::DrawElements> elements;
+
+            if (batch.vertexCount <= 0x10000)
+            {
+                elements = new osg::DrawElementsUShort(GL_TRIANGLES, batch.indices.begin(), batch.indices.end());
+            }
+            else
+            {
+                elements = new osg::DrawElementsUInt(GL_TRIANGLES, batch.indices.begin(), batch.indices.end());
+            }
+
+            geometry->addPrimitiveSet(elements.get());
+
+            geometry->setUseDisplayList(false);
+            geometry->setUseVertexBufferObjects(true);
+
+            batches->addChild(geometry);
+
+            for (const osg::Array* array : { geometry->getVertexArray(), geometry->getNormalArray(), geometry->getColorArray() })
+            {
+                if (array != nullptr && counted.insert(array).second) stats.vertexBytes += array->getTotalDataSize();
+            }
+
+            for (unsigned int unit = 0; unit < geometry->getNumTexCoordArrays(); ++unit)
+            {
+                if (const osg::Array* array = geometry->getTexCoordArray(unit); array != nullptr && counted.insert(array).second)
+                {
+                    stats.vertexBytes += array->getTotalDataSize();
+                }
+            }
+
+            stats.indexBytes += elements->getTotalDataSize();
+            stats.batches++;
+        }
+
+        return stats;
+    }
+}
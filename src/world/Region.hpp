@@ -1,32 +1,171 @@
 
 #pragma once
 
+#include <osg/Drawable>
 #include <osg/MatrixTransform>
 
 #include <unordered_map>
+#include <vector>
+
+#include "osg/SiegeNodeMesh.hpp"
 
 namespace ehb
 {
     class Region final : public osg::MatrixTransform
     {
+        friend class NavGraph;
         friend class ReaderWriterSiegeNodeList;
 
     public:
 
+        //! what the batching pass merged
+        struct BatchStats final
+        {
+            size_t drawables = 0;   //!< node drawables now drawn from a batch
+            size_t batches = 0;
+            size_t vertexBytes = 0;
+            size_t indexBytes = 0;
+        };
+
+        //! a floor or water face found by a query
+        struct SurfaceHit final
+        {
+            uint32_t guid = 0;              //!< the node the face belongs to
+            osg::Vec3 position;             //!< in the space of that node
+            osg::Vec3 normal;
+            float ratio = 0;                //!< how far along the query segment the face is
+            SiegeNodeMesh::FloorFlag flag = SiegeNodeMesh::FloorFlag::FLOOR_FLOOR;
+            uint8_t logicalNode = 0;        //!< id of the logical node the face belongs to
+        };
+
+        //! what placing the nodes did
+        struct PlacementStats final
+        {
+            size_t placed = 0;              //!< nodes reached from the target node, the target included
+            size_t connections = 0;         //!< doors a node was placed through
+            size_t missingDoors = 0;        //!< doors a node couldn't be placed through since a mesh doesn't have them
+        };
+
+        //! a door of a node and the door of the node it leads to
+        struct DoorLink final
+        {
+            uint32_t guid = 0;
+            uint32_t door = 0;
+            uint32_t farGuid = 0;
+            uint32_t farDoor = 0;
+        };
+
         Region() = default;
 
+        //! adds a node under guid, it stays where it is until the nodes are placed
+        void addNode(uint32_t guid, osg::MatrixTransform* xform);
+
+        //! records that a door of one node leads to a door of another, as listed by the [door*] blocks of the first node
+        void addDoorLink(const DoorLink& link);
+
+        /*
+         * moves every node reachable from targetGuid through the door links so its doors line up with the node it is
+         * reached from, the target node stays where it is. the nodes are visited breadth first from a queue so any size
+         * of region is placed without recursing, nodes that can't be reached are left where they are
+         */
+        PlacementStats placeNodes(uint32_t targetGuid);
+
         const osg::MatrixTransform* targetNode() const;
         const uint32_t targetNodeGuid() const;
 
         const osg::MatrixTransform* transformForGuid(const uint32_t guid) const;
 
+        /*
+         * the first floor or water face on the segment from start to end, both in the space of the region
+         *
+         * only the logical node faces of each mesh are looked at and nodes whose faces are nowhere near the segment are
+         * skipped without looking at their mesh, so this is far cheaper than intersecting the scene graph
+         */
+        bool raycast(const osg::Vec3& start, const osg::Vec3& end, SurfaceHit& hit) const;
+
+        //! the highest floor or water face at or straight below point, in the space of the region
+        bool heightAt(const osg::Vec3& point, SurfaceHit& hit) const;
+
+        //! holds the floor and water faces of every node, invalid if there aren't any
+        const osg::BoundingBox& surfaceBounds() const;
+
+        //! draws the batches in place of the node geometry they were built from, every other visitor sees the nodes as usual
+        virtual void traverse(osg::NodeVisitor& nv) override;
+
+        virtual void resizeGLObjectBuffers(unsigned int maxSize) override;
+        virtual void releaseGLObjects(osg::State* state = nullptr) const override;
+
     protected:
 
         virtual ~Region() = default;
 
     private:
 
+        class BatchedCullCallback;
+
+        //! the one callback every batchable drawable shares
+        static osg::DrawableCullCallback* batchedCullCallback();
+
+        /*
+         * marks every drawable of a freshly read mesh that a region can merge into its batches. this has to happen before
+         * the mesh is shared with any other region since those may already be drawing it
+         */
+        static void prepareForBatching(SiegeNodeMesh& mesh);
+
+        /*
+         * merges the marked drawables of every placed node into one geometry per state set, with the node transforms baked
+         * into the vertices, so the whole region draws with one call per texture
+         *
+         * the nodes, their guids and their meshes stay where they are so picking, the guid lookups and debug drawing work
+         * as before. the batches are only ever seen by the cull visitor so this has to be run again if the nodes are moved
+         */
+        BatchStats buildDrawBatches();
+
+        /*
+         * records where the floor and water faces of every placed node are so raycast and heightAt don't have to go
+         * through the scene graph, this has to be run again if the nodes are moved
+         */
+        void buildSurfaceIndex();
+
+        //! @param candidates indices into surfaceNodes to test, every node when nullptr
+        bool cast(const osg::Vec3& start, const osg::Vec3& end, const uint32_t* candidates, size_t count, SurfaceHit& hit) const;
+
+    private:
+
+        //! a node as the surface queries see it
+        struct SurfaceNode final
+        {
+            osg::BoundingBox bounds;        //!< its floor and water faces in the space of the region
+            osg::Matrix inverse;            //!< from the space of the region to the space of the node
+            const SiegeNodeMesh* mesh = nullptr;
+            uint32_t guid = 0;
+        };
+
         // holds a mapping from the guid to the final matrix transform of the placed nodes
         std::unordered_map<uint32_t, osg::ref_ptr<osg::MatrixTransform>> nodeMap;
+
+        //! every [door*] entry whose nodes were both added, in file order
+        std::vector<DoorLink> doorLinks;
+
+        osg::ref_ptr<osg::Group> batches;
+
+        //! node transforms whose mesh is drawn entirely from the batches, they are only culled for debug drawing
+        std::unordered_map<const osg::Node*, const SiegeNodeMesh*> batchedNodes;
+
+        std::vector<SurfaceNode> surfaceNodes;
+        osg::BoundingBox surfaceBox;
+
+        /*
+         * the surface nodes overlapping each cell of a grid laid over the region from above, a height query only has to
+         * look at the nodes of the one cell it lands in. cell i holds gridNodes[gridStart[i]] up to gridNodes[gridStart[i + 1]]
+         */
+        float gridCellSize = 0;
+        uint32_t gridColumns = 0, gridRows = 0;
+        std::vector<uint32_t> gridStart, gridNodes;
     };
-}
\ No newline at end of file
+
+    inline const osg::BoundingBox& Region::surfaceBounds() const
+    {
+        return surfaceBox;
+    }
+}